@@ -1,195 +1,323 @@
 #include <stdio.h>
 #include <float.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <stdbool.h>
 
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "grafo_csr.h"
+#include "leitura_grafo.h"
+#include "cronometro.h"
+
+// Com -q os passos do algoritmo não são exibidos (para medir o tempo em grafos grandes)
+static bool verboso = true;
+
 typedef struct Grafo Grafo;
 typedef struct Vertice Vertice;
-typedef struct No No;
 
 struct Grafo {
 	int qtd_vertices;
 	Vertice *vertices;
+	GrafoCSR *adj;  // arcos de u em adj->vizinhos/adj->pesos[adj->inicio[u] .. adj->inicio[u + 1] - 1]
+	int *ciclo;     // ciclo negativo encontrado (v0, v1, ..., v0 fica implícito), ou NULL
+	int tam_ciclo;
 };
 
 struct Vertice {
 	float d;
 	int pai;
-	No *lista_adjacencia;
 };
 
-struct No {
-	int vertice;
-	float peso;
-	No *proximo_no;
-};
+Grafo *criar_grafo(GrafoCSR *adj) {  // O grafo passa a ser dono de adj
+	if (!adj)
+		return NULL;
 
-Grafo *criar_grafo(int qtd_vertices) {
 	Grafo *g = (Grafo *) malloc(sizeof(Grafo));
 
 	if (g) {
-    	g->vertices = (Vertice *) malloc(qtd_vertices * sizeof(Vertice));
+		g->vertices = (Vertice *) malloc(adj->qtd_vertices * sizeof(Vertice));
 
-    	if (g->vertices) {
-        	g->qtd_vertices = qtd_vertices;
-
-        	for (int i = 0; i < g->qtd_vertices; i++)
-            	g->vertices[i].lista_adjacencia = NULL;
-       	 
-        	return g;
-    	}
-    	free(g);
+		if (g->vertices) {
+			g->qtd_vertices = adj->qtd_vertices;
+			g->adj = adj;
+			g->ciclo = NULL;
+			g->tam_ciclo = 0;
+			return g;
+		}
+		free(g);
 	}
+	desalocar_grafo_csr(adj);
 
 	return NULL;
 }
 
 void desalocar_grafo(Grafo *g) {
 	if (g) {
-    	if (g->vertices) {
-        	No *no_atual = NULL, *prox = NULL;
-       	 
-        	for (int i = 0; i < g->qtd_vertices; i++) {
-            	no_atual = g->vertices[i].lista_adjacencia;
-
-            	while (no_atual) {
-                	prox = no_atual->proximo_no;
-                	free(no_atual);
-                	no_atual = prox;
-            	}
-        	}
-        	free(g->vertices);
-    	}
-    	free(g);
-	}
-}
-
-No *criar_no_adjacente(int vertice, float peso) {  // "vertice" é a posição do vértice vizinho no array
-	No *novo_no = (No*) malloc(sizeof(No));
-
-	if (novo_no) {
-    	novo_no->vertice = vertice;
-    	novo_no->peso = peso;
-    	novo_no->proximo_no = NULL;
-    	return novo_no;
-	}
-	return NULL;
-}
-
-int aresta_existe(Grafo *g, int u, int v) {
-	No *no_atual = g->vertices[u].lista_adjacencia;
-    
-	// Percorre a lista adj. de u para verificar se v já está nela
-	while (no_atual) {
-    	if (no_atual->vertice == v)
-        	return 1; // (u,v) já existe   
-    	no_atual = no_atual->proximo_no;
-	}
-	return 0; // (u,v) não existe no grafo
-}
-
-void inserir_aresta(Grafo *g, int eh_grafo_dirigido, int u, int v, float peso) {
-	if (g && !aresta_existe(g, u, v)) {
-    	No *vizinho = criar_no_adjacente(v, peso);
-
-    	if (vizinho) {
-        	// Colocando v na lista adj. de u
-        	vizinho->proximo_no = g->vertices[u].lista_adjacencia;
-        	g->vertices[u].lista_adjacencia = vizinho;
-       	 
-        	// Coloca u na lista adj. de v quando o grafo for simples
-        	vizinho = criar_no_adjacente(u, peso);
-        	if (!eh_grafo_dirigido && vizinho) {
-            	vizinho->proximo_no = g->vertices[v].lista_adjacencia;
-            	g->vertices[v].lista_adjacencia = vizinho;
-        	}
-    	}
+		desalocar_grafo_csr(g->adj);
+		free(g->vertices);
+		free(g->ciclo);
+		free(g);
 	}
 }
 
 void inicializar_fonte_unica(Grafo *g, int s) {
-	printf("O inicializar_fonte_unica está prestes a executar.\n");
+	if (verboso)
+		printf("O inicializar_fonte_unica está prestes a executar.\n");
 	for (int i = 0; i < g->qtd_vertices; i++) {
     	g->vertices[i].d = FLT_MAX;
     	g->vertices[i].pai = -1;
-		printf("O vértice %d tem pai %d e estimativa inicial de %f.\n", i, g->vertices[i].pai, g->vertices[i].d);
+		if (verboso)
+			printf("O vértice %d tem pai %d e estimativa inicial de %f.\n", i, g->vertices[i].pai, g->vertices[i].d);
 	}
 	g->vertices[s].d = 0;
-	printf("O vértice fonte s = %d teve sua estimativa atualizada para %f\n", s, g->vertices[s].d);
-	printf("inicializar_fonte_unica totalmente finalizado.\n\n");
+	if (verboso) {
+		printf("O vértice fonte s = %d teve sua estimativa atualizada para %f\n", s, g->vertices[s].d);
+		printf("inicializar_fonte_unica totalmente finalizado.\n\n");
+	}
 }
 
-void relaxar(Grafo *g, int u, int v, float peso) {
-	printf("Estimativa do vértice v = %d: %f.\n", v, g->vertices[v].d);
-	printf("Estimativa do vértive u = %d: %f.\n", u, g->vertices[u].d);
-	printf("w(%d,%d) = %f.\n", u, v, peso);
+// Retorna true se a estimativa de v diminuiu
+bool relaxar(Grafo *g, int u, int v, float peso) {
+	if (verboso) {
+		printf("Estimativa do vértice v = %d: %f.\n", v, g->vertices[v].d);
+		printf("Estimativa do vértive u = %d: %f.\n", u, g->vertices[u].d);
+		printf("w(%d,%d) = %f.\n", u, v, peso);
+	}
 
 	if (g->vertices[v].d > g->vertices[u].d + peso) {
-		printf("A aresta (%d,%d) com peso w(%d,%d) = %f irá relaxar, pois %f > %f + (%f).\n", 
-		u, v, u, v, peso, g->vertices[v].d, g->vertices[u].d, peso);
+		if (verboso)
+			printf("A aresta (%d,%d) com peso w(%d,%d) = %f irá relaxar, pois %f > %f + (%f).\n", 
+			u, v, u, v, peso, g->vertices[v].d, g->vertices[u].d, peso);
 
     	g->vertices[v].d = g->vertices[u].d + peso;
     	g->vertices[v].pai = u;
-	} else
+		return true;
+	}
+	if (verboso)
 		printf("A aresta (%d,%d) com peso w(%d,%d) = %f não sofreu relaxamento.\n",
 		u, v, u, v, peso);
+	return false;
+}
+
+/*
+ * Guarda em g->ciclo o ciclo dos pais que passa por w, na ordem dos arcos: subir pelos pais dá
+ * o ciclo ao contrário, então ele é invertido no fim
+ */
+void registrar_ciclo(Grafo *g, int w) {
+	free(g->ciclo);
+	g->ciclo = (int *) malloc(g->qtd_vertices * sizeof(int));
+	assert(g->ciclo != NULL);
+
+	int tam = 0, x = w;
+	do {
+		g->ciclo[tam++] = x;
+		x = g->vertices[x].pai;
+	} while (x != w);
+
+	for (int i = 0, j = tam - 1; i < j; i++, j--) {
+		int aux = g->ciclo[i];
+		g->ciclo[i] = g->ciclo[j];
+		g->ciclo[j] = aux;
+	}
+	g->tam_ciclo = tam;
 }
 
 bool bellman_ford(Grafo *g, int s) {
 	inicializar_fonte_unica(g, s);
 
 	for (int i = 0; i < g->qtd_vertices - 1; i++) {
-    	for (int u = 0; u < g->qtd_vertices; u++) {
-        	No *aux = g->vertices[u].lista_adjacencia;
-       	
-        	while (aux) {
-            	relaxar(g, u, aux->vertice, aux->peso);
-            	aux = aux->proximo_no;
-        	}
-    	}
+    	for (int u = 0; u < g->qtd_vertices; u++)
+        	for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++)
+            	relaxar(g, u, g->adj->vizinhos[e], g->adj->pesos[e]);
 	}
     
-	printf("Checagem de restrição de ciclo prestes a começar.\n");
+	if (verboso)
+		printf("Checagem de restrição de ciclo prestes a começar.\n");
 	for (int u = 0; u < g->qtd_vertices; u++) {
-    	No *aux = g->vertices[u].lista_adjacencia;
-       	 
-    	while (aux) {
-        	if (g->vertices[aux->vertice].d > g->vertices[u].d + aux->peso) {
+    	for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+			int v = g->adj->vizinhos[e];
+			float peso = g->adj->pesos[e];
+
+        	if (g->vertices[v].d > g->vertices[u].d + peso) {
 				printf("Ops! Ciclo encontrado!\n");
-				printf("%f > %f + %f\n", g->vertices[aux->vertice].d, g->vertices[u].d, aux->peso);
-				printf("(%d,%d) com w(%d,%d) = %f\n", u, aux->vertice, u, aux->vertice, aux->peso);
+				printf("%f > %f + %f\n", g->vertices[v].d, g->vertices[u].d, peso);
+				printf("(%d,%d) com w(%d,%d) = %f\n", u, v, u, v, peso);
+
+				// Com pai[v] = u, subir V vezes pelos pais a partir de v termina dentro do ciclo
+				g->vertices[v].pai = u;
+				int w = v;
+				for (int i = 0; i < g->qtd_vertices && w != -1; i++)
+					w = g->vertices[w].pai;
+				if (w != -1)
+					registrar_ciclo(g, w);
             	return false;
 			}
-        	aux = aux->proximo_no;
     	}
 	}
-	printf("Nenhuma restrição de ciclo encontrada.\n");
+	if (verboso)
+		printf("Nenhuma restrição de ciclo encontrada.\n");
 	return true;
 }
 
+/*
+ * Procura um ciclo no grafo dos pais em O(V): sobe pelos pais a partir de cada vértice ainda
+ * não visitado, marcando o caminho com o índice do vértice de partida. Chegar a um vértice
+ * marcado nesta mesma subida fecha um ciclo. marca é um arranjo de V posições.
+ */
+int vertice_em_ciclo_de_pais(Grafo *g, int *marca) {
+	for (int v = 0; v < g->qtd_vertices; v++)
+		marca[v] = -1;
+
+	for (int v = 0; v < g->qtd_vertices; v++) {
+		int w = v;
+
+		while (w != -1 && marca[w] == -1) {
+			marca[w] = v;
+			w = g->vertices[w].pai;
+		}
+		if (w != -1 && marca[w] == v)
+			return w;
+	}
+	return -1;
+}
+
+/*
+ * Bellman-Ford com fila (SPFA): em vez de V - 1 passadas sobre todos os arcos, só os vértices
+ * cuja estimativa mudou voltam a relaxar os seus arcos. A fila é FIFO e circular; o mapa de
+ * bits na_fila impede que um vértice entre nela duas vezes, então V posições bastam. O
+ * algoritmo termina quando a fila esvazia.
+ *
+ * Ciclos negativos são detectados de dois jeitos, sem esperar pelas V - 1 passadas:
+ *   - arcos[v] guarda quantos arcos tem o caminho de s a v pelos pais no momento em que d[v]
+ *     foi definida. Sem ciclo negativo, todo caminho mínimo tem no máximo V - 1 arcos; se
+ *     arcos[v] chega a V, o caminho repete um vértice e passa por um ciclo negativo.
+ *   - a cada V relaxamentos, os pais são percorridos à procura de um ciclo (custo O(V),
+ *     diluído entre os relaxamentos). Todo ciclo nos pais é um ciclo negativo, e ele costuma
+ *     aparecer bem antes de arcos[v] chegar a V, que exige dar muitas voltas no ciclo.
+ *
+ * Sem ciclo negativo, d é a mesma do bellman_ford(). pai também, exceto quando há mais de um
+ * caminho mínimo até um vértice e o empate é desfeito de outro jeito.
+ */
+bool bellman_ford_fila(Grafo *g, int s) {
+	int n = g->qtd_vertices;
+	int *fila = (int *) malloc(n * sizeof(int));
+	int *arcos = (int *) malloc(n * sizeof(int));
+	int *marca = (int *) malloc(n * sizeof(int));
+	uint64_t *na_fila = (uint64_t *) calloc((n + 63) / 64, sizeof(uint64_t));
+	bool resultado = true;
+	long relaxamentos = 0;
+
+	assert(fila != NULL && arcos != NULL && marca != NULL && na_fila != NULL);
+
+	inicializar_fonte_unica(g, s);
+
+	int inicio = 0, qtd = 1;
+	fila[0] = s;
+	arcos[s] = 0;
+	na_fila[s / 64] |= 1ull << (s % 64);
+
+	while (qtd > 0 && resultado) {
+		int u = fila[inicio];
+
+		inicio = (inicio + 1 == n) ? 0 : inicio + 1;
+		qtd--;
+		na_fila[u / 64] &= ~(1ull << (u % 64));
+
+		if (verboso)
+			printf("Vértice %d retirado da fila (%d restantes).\n", u, qtd);
+
+		for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+			int v = g->adj->vizinhos[e];
+			float peso = g->adj->pesos[e];
+
+			if (!relaxar(g, u, v, peso))
+				continue;
+
+			arcos[v] = arcos[u] + 1;
+			if (arcos[v] >= n) {
+				printf("Ops! Ciclo encontrado!\n");
+				printf("O caminho de pais até %d tem %d arcos.\n", v, arcos[v]);
+				printf("(%d,%d) com w(%d,%d) = %f\n", u, v, u, v, peso);
+
+				int w = vertice_em_ciclo_de_pais(g, marca);
+				if (w != -1)
+					registrar_ciclo(g, w);
+				resultado = false;
+				break;
+			}
+			if (++relaxamentos % n == 0) {
+				int w = vertice_em_ciclo_de_pais(g, marca);
+
+				if (w != -1) {
+					printf("Ops! Ciclo encontrado!\n");
+					printf("Os pais formam um ciclo que passa por %d.\n", w);
+					printf("(%d,%d) com w(%d,%d) = %f foi o último relaxamento.\n", u, v, u, v, peso);
+					registrar_ciclo(g, w);
+					resultado = false;
+					break;
+				}
+			}
+			if (!(na_fila[v / 64] & (1ull << (v % 64)))) {
+				int fim = inicio + qtd < n ? inicio + qtd : inicio + qtd - n;
+
+				fila[fim] = v;
+				qtd++;
+				na_fila[v / 64] |= 1ull << (v % 64);
+			}
+		}
+	}
+
+	if (resultado && verboso)
+		printf("Fila vazia: nenhuma restrição de ciclo encontrada.\n");
+
+	free(fila);
+	free(arcos);
+	free(marca);
+	free(na_fila);
+	return resultado;
+}
+
+void exibir_arestas(Grafo *g) {
+	for (int u = 0; u < g->qtd_vertices; u++) {
+		for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+			int v = g->adj->vizinhos[e];
+
+			if (g->adj->eh_dirigido || u <= v)  // cada aresta não dirigida aparece uma vez só
+				printf("Aresta (%d,%d) com peso w(%d,%d) = %f adicionada ao grafo.\n", u, v, u, v, g->adj->pesos[e]);
+		}
+	}
+	printf("\n");
+}
+
 void exibir_lista_adjacencia(Grafo *g) {
 	if (g) {
-    	No *no_atual = NULL;
+		for (int i = 0; i < g->qtd_vertices; i++) {
+			printf("\n[%d]", i);
 
-    	for (int i = 0; i < g->qtd_vertices; i++) {
-        	no_atual = g->vertices[i].lista_adjacencia;
-        	printf("\n[%d]", i);
-
-        	while (no_atual) {
-            	printf(" ~> [%d, %f]", no_atual->vertice, no_atual->peso);
-            	no_atual = no_atual->proximo_no;
-        	}
-    	}
-    	printf("\n\n");
+			for (int e = g->adj->inicio[i]; e < g->adj->inicio[i + 1]; e++)
+				printf(" ~> [%d, %f]", g->adj->vizinhos[e], g->adj->pesos[e]);
+		}
+		printf("\n\n");
 	}
 }
 
+// Com um ciclo negativo os pais podem formar um ciclo: a subida para depois de V passos
 void exibir_caminho_minimo(Grafo *g, int u) {
 	int pai = u;
 
 	printf("%d ", u);
-	while(pai != -1) {
+	for (int passos = 0; pai != -1; passos++) {
+		if (passos == g->qtd_vertices) {
+			printf("<~ ... (ciclo)");
+			return;
+		}
     	pai = g->vertices[pai].pai;
 		printf("<~ %d ", pai);
 	}
@@ -209,26 +337,350 @@ void exibir_resumo_grafo(Grafo *g) {
     }
 }
 
-int main(void) {
-	int eh_grafo_direcionado, qtd_vertices, u, v;
-	float peso = 0;
+/*
+ * Bellman-Ford com fila e desmontagem de subárvores (Tarjan). A árvore de caminhos mínimos é
+ * mantida explicitamente, numa lista em pré-ordem (prox e ant) com a profundidade de cada
+ * vértice. Quando d[v] diminui pelo arco (u, v), a subárvore de v sai da árvore: as estimativas
+ * dos descendentes vieram do d[v] antigo, então eles não são processados ao sair da fila até
+ * melhorarem de novo. Se u estiver nessa subárvore, o caminho de v a u pela árvore mais o arco
+ * (u, v) é um ciclo negativo, encontrado no primeiro relaxamento que o fecha, sem passadas nem
+ * buscas periódicas.
+ *
+ * prof[v] == -1 indica um vértice fora da árvore (ainda não alcançado ou desmontado).
+ */
+bool bellman_ford_tarjan(Grafo *g, int s) {
+	int n = g->qtd_vertices;
+	int *fila = (int *) malloc(n * sizeof(int));
+	int *prox = (int *) malloc(n * sizeof(int));
+	int *ant = (int *) malloc(n * sizeof(int));
+	int *prof = (int *) malloc(n * sizeof(int));
+	uint64_t *na_fila = (uint64_t *) calloc((n + 63) / 64, sizeof(uint64_t));
+	bool resultado = true;
+
+	assert(fila != NULL && prox != NULL && ant != NULL && prof != NULL && na_fila != NULL);
+
+	inicializar_fonte_unica(g, s);
+
+	for (int v = 0; v < n; v++)
+		prof[v] = -1;
+	prof[s] = 0;
+	prox[s] = ant[s] = -1;
+
+	int inicio = 0, qtd = 1;
+	fila[0] = s;
+	na_fila[s / 64] |= 1ull << (s % 64);
+
+	while (qtd > 0 && resultado) {
+		int u = fila[inicio];
+
+		inicio = (inicio + 1 == n) ? 0 : inicio + 1;
+		qtd--;
+		na_fila[u / 64] &= ~(1ull << (u % 64));
+
+		if (prof[u] == -1)
+			continue;  // desmontado depois de entrar na fila: d[u] vai melhorar de novo
+		if (verboso)
+			printf("Vértice %d retirado da fila (%d restantes).\n", u, qtd);
+
+		for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1] && resultado; e++) {
+			int v = g->adj->vizinhos[e];
+			float peso = g->adj->pesos[e];
+
+			if (!relaxar(g, u, v, peso))
+				continue;
+
+			if (prof[v] != -1) {
+				// Desmonta a subárvore de v: os vértices seguintes na pré-ordem com profundidade maior
+				int x = prox[v];
+
+				if (u == v)
+					resultado = false;
+				while (x != -1 && prof[x] > prof[v]) {
+					if (x == u)
+						resultado = false;
+					prof[x] = -1;
+					x = prox[x];
+				}
+				if (!resultado) {
+					// relaxar() já fez pai[v] = u, e como u está na subárvore de v, subir de u pelos pais chega a v
+					printf("Ops! Ciclo encontrado!\n");
+					printf("%d é descendente de %d na árvore de caminhos mínimos.\n", u, v);
+					printf("(%d,%d) com w(%d,%d) = %f\n", u, v, u, v, peso);
+					registrar_ciclo(g, v);
+					break;
+				}
+
+				// Tira v e a subárvore da lista
+				if (ant[v] != -1)
+					prox[ant[v]] = x;
+				if (x != -1)
+					ant[x] = ant[v];
+			}
+
+			// v passa a ser o primeiro filho de u
+			prof[v] = prof[u] + 1;
+			ant[v] = u;
+			prox[v] = prox[u];
+			if (prox[u] != -1)
+				ant[prox[u]] = v;
+			prox[u] = v;
+
+			if (!(na_fila[v / 64] & (1ull << (v % 64)))) {
+				int fim = inicio + qtd < n ? inicio + qtd : inicio + qtd - n;
+
+				fila[fim] = v;
+				qtd++;
+				na_fila[v / 64] |= 1ull << (v % 64);
+			}
+		}
+	}
+
+	if (resultado && verboso)
+		printf("Fila vazia: nenhuma restrição de ciclo encontrada.\n");
+
+	free(fila);
+	free(prox);
+	free(ant);
+	free(prof);
+	free(na_fila);
+	return resultado;
+}
+
+/*
+ * Bellman-Ford centrado nos arcos, em paralelo. Os arcos ficam em três arranjos separados
+ * (origem, destino e peso, uma estrutura de arranjos): destino e peso são os próprios arranjos
+ * do GrafoCSR, na mesma ordem, e só origem é montado. Cada passada percorre o arranjo inteiro
+ * dividido entre as threads, e termina assim que uma passada não melhora nenhuma estimativa.
+ * Depois de cada passada com melhoras, os pais são percorridos à procura de um ciclo (O(V),
+ * pouco perto da passada), para que um ciclo negativo não exija as V passadas.
+ *
+ * Como no delta-stepping do dijkstra, (d, pai) de um vértice ficam numa palavra de 64 bits
+ * trocada por compare-and-swap só quando a nova estimativa é menor, então duas threads que
+ * relaxam o mesmo vértice nunca deixam d de um arco e pai de outro. Sem ciclo negativo, d é a
+ * mesma do bellman_ford(); pai também, a menos de empates entre caminhos mínimos.
+ */
+
+typedef struct ListaArcos {
+	long qtd;
+	int *origem;
+	const int *destino;   // g->adj->vizinhos
+	const float *peso;   // g->adj->pesos
+} ListaArcos;
+
+// (d, pai) de um vértice lidos e gravados juntos numa palavra de 64 bits
+typedef uint64_t __attribute__((may_alias)) PalavraVertice;
+
+static bool montar_lista_arcos(const GrafoCSR *adj, ListaArcos *l) {
+	l->qtd = adj->qtd_arcos;
+	l->origem = (int *) malloc((l->qtd > 0 ? l->qtd : 1) * sizeof(int));
+	l->destino = adj->vizinhos;
+	l->peso = adj->pesos;
+
+	if (!l->origem)
+		return false;
+
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int u = 0; u < adj->qtd_vertices; u++)
+		for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++)
+			l->origem[e] = u;
+	return true;
+}
+
+// Relaxamento concorrente: troca (d, pai) de v por (nova_d, u) só se nova_d for menor
+static bool relaxar_atomico(Grafo *g, int u, int v, float nova_d) {
+	PalavraVertice *palavra = (PalavraVertice *) &g->vertices[v];
+	PalavraVertice antiga = __atomic_load_n(palavra, __ATOMIC_RELAXED);
+	Vertice novo = { nova_d, u };
+	PalavraVertice nova;
+
+	memcpy(&nova, &novo, sizeof(nova));
+
+	for (;;) {
+		Vertice atual;
+		memcpy(&atual, &antiga, sizeof(atual));
+
+		if (nova_d >= atual.d)
+			return false;
+		if (__atomic_compare_exchange_n(palavra, &antiga, nova, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			return true;
+	}
+}
+
+// Uma passada sobre todos os arcos; retorna true se alguma estimativa diminuiu
+static bool passada_paralela(Grafo *g, const ListaArcos *l) {
+	bool mudou = false;
+
+	#pragma omp parallel for schedule(static) reduction(||: mudou)
+	for (long e = 0; e < l->qtd; e++) {
+		int u = l->origem[e];
+		float d_u;
+
+		__atomic_load(&g->vertices[u].d, &d_u, __ATOMIC_RELAXED);
+
+		// Vértices ainda não alcançados não relaxam nada (FLT_MAX + peso não é uma distância)
+		if (d_u != FLT_MAX && relaxar_atomico(g, u, l->destino[e], d_u + l->peso[e]))
+			mudou = true;
+	}
+	return mudou;
+}
+
+bool bellman_ford_arestas(Grafo *g, int s, int *qtd_passadas) {
+	int n = g->qtd_vertices;
+	ListaArcos l;
+	int *marca = (int *) malloc(n * sizeof(int));
+
+	*qtd_passadas = 0;
+	if (!marca || !montar_lista_arcos(g->adj, &l)) {
+		fprintf(stderr, "Memória insuficiente.\n");
+		free(marca);
+		return false;
+	}
+
+	#pragma omp parallel for
+	for (int i = 0; i < n; i++) {
+		g->vertices[i].d = FLT_MAX;
+		g->vertices[i].pai = -1;
+	}
+	g->vertices[s].d = 0;
+
+	// Se as V - 1 passadas ainda mudaram algo, a V-ésima é a checagem de ciclo: mudar de novo é ciclo negativo
+	bool mudou = true;
+	int passada, w = -1;
+	for (passada = 0; passada < n && mudou && w == -1; passada++) {
+		mudou = passada_paralela(g, &l);
+		if (verboso)
+			printf("Passada %d: %s\n", passada + 1, mudou ? "houve relaxamentos" : "nada mudou");
+		if (mudou)
+			w = vertice_em_ciclo_de_pais(g, marca);
+	}
+	*qtd_passadas = passada;
+
+	if (mudou) {
+		printf("Ops! Ciclo encontrado!\n");
+		if (w != -1) {
+			printf("Os pais formam um ciclo que passa por %d depois da passada %d.\n", w, passada);
+			registrar_ciclo(g, w);
+		} else
+			printf("A passada %d ainda relaxou arcos.\n", passada);
+	} else if (verboso)
+		printf("Nenhuma restrição de ciclo encontrada.\n");
+
+	free(marca);
+	free(l.origem);
+	return !mudou;
+}
+
+typedef enum Modo { MODO_CLASSICO, MODO_FILA, MODO_TARJAN, MODO_ARESTAS } Modo;
+
+void exibir_ciclo(Grafo *g) {
+	double total = 0;
+
+	printf("Ciclo negativo com %d arcos:", g->tam_ciclo);
+	for (int i = 0; i < g->tam_ciclo; i++) {
+		int u = g->ciclo[i], v = g->ciclo[(i + 1) % g->tam_ciclo];
+
+		total += g->adj->pesos[posicao_arco_csr(g->adj, u, v)];  // os arcos do ciclo vêm do próprio grafo
+		printf(" %d ->", u);
+	}
+	printf(" %d (peso total %f)\n", g->ciclo[0], total);
+}
+
+void exibir_uso(const char *programa) {
+	fprintf(stderr, "Uso: %s [-m modo] [-s fonte] [-T threads] [-q] < grafo\n", programa);
+	fprintf(stderr, "  -m modo     classico (padrão, V - 1 passadas sobre todos os arcos),\n");
+	fprintf(stderr, "              fila (SPFA: só os vértices cuja estimativa mudou),\n");
+	fprintf(stderr, "              tarjan (fila com desmontagem de subárvores: acha ciclos negativos cedo)\n");
+	fprintf(stderr, "              ou arestas (passadas paralelas sobre o arranjo de arcos)\n");
+	fprintf(stderr, "  -s fonte    vértice de origem (padrão 0)\n");
+	fprintf(stderr, "  -T threads  quantidade de threads do modo arestas\n");
+	fprintf(stderr, "  -q          não exibe os passos nem a tabela final, só o resultado e o tempo\n");
+}
+
+int main(int argc, char *argv[]) {
+	Modo modo = MODO_CLASSICO;
+	int s = 0, opcao;
+
+	while ((opcao = getopt(argc, argv, "m:s:T:q")) != -1) {
+		switch (opcao) {
+			case 'm':
+				if (strcmp(optarg, "classico") == 0)
+					modo = MODO_CLASSICO;
+				else if (strcmp(optarg, "fila") == 0)
+					modo = MODO_FILA;
+				else if (strcmp(optarg, "tarjan") == 0)
+					modo = MODO_TARJAN;
+				else if (strcmp(optarg, "arestas") == 0)
+					modo = MODO_ARESTAS;
+				else {
+					exibir_uso(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 's':
+				s = atoi(optarg);
+				break;
+			case 'T':
+#ifdef _OPENMP
+				omp_set_num_threads(atoi(optarg));
+#endif
+				break;
+			case 'q':
+				verboso = false;
+				break;
+			default:
+				exibir_uso(argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	// Entrada em texto (.graph) ou no formato binário gerado pelo converter_grafo
+	Grafo *g = criar_grafo(carregar_grafo(STDIN_FILENO, true));
     
-	if (fscanf(stdin, "%d %d", &eh_grafo_direcionado, &qtd_vertices) == 2) {
-    	Grafo *g = criar_grafo(qtd_vertices);
-   	 
-    	while (fscanf(stdin, "%d %d %f", &u, &v, &peso) != EOF) {
-        	inserir_aresta(g, eh_grafo_direcionado, u, v, peso);
-			printf("Aresta (%d,%d) com peso w(%d,%d) = %f adicionada ao grafo.\n", u, v, u, v, peso);
+	if (g) {
+		if (s < 0 || s >= g->qtd_vertices) {
+			fprintf(stderr, "Vértice fonte fora do intervalo [0, %d).\n", g->qtd_vertices);
+			desalocar_grafo(g);
+			return EXIT_FAILURE;
 		}
-		printf("\n");
 
-		printf("Grafo de entrada:");
-		exibir_lista_adjacencia(g);
-	 	printf("O algoritmo de Bellman-ford obteve êxito? %d.\n", bellman_ford(g, 0));
-		exibir_resumo_grafo(g);
+		if (verboso) {
+			exibir_arestas(g);
+			printf("Grafo de entrada:");
+			exibir_lista_adjacencia(g);
+		}
+
+		int qtd_passadas = 0;
+		double inicio = tempo_atual();
+		bool exito;
+		if (modo == MODO_ARESTAS)
+			exito = bellman_ford_arestas(g, s, &qtd_passadas);
+		else if (modo == MODO_FILA)
+			exito = bellman_ford_fila(g, s);
+		else if (modo == MODO_TARJAN)
+			exito = bellman_ford_tarjan(g, s);
+		else
+			exito = bellman_ford(g, s);
+		double fim = tempo_atual();
+
+	 	printf("O algoritmo de Bellman-ford obteve êxito? %d.\n", exito);
+		if (g->ciclo)
+			exibir_ciclo(g);
+		if (verboso)
+			exibir_resumo_grafo(g);
+		else if (modo == MODO_ARESTAS) {
+			int qtd_threads = 1;
+#ifdef _OPENMP
+			qtd_threads = omp_get_max_threads();
+#endif
+			printf("Bellman-Ford por arestas (%d thread%s, %d passadas) a partir de %d: %.3f s\n",
+			       qtd_threads, qtd_threads > 1 ? "s" : "", qtd_passadas, s, fim - inicio);
+		} else
+			printf("Bellman-Ford %s a partir de %d: %.3f s\n",
+			       modo == MODO_TARJAN ? "com desmontagem de subárvores" : modo == MODO_FILA ? "com fila" : "clássico",
+			       s, fim - inicio);
     	desalocar_grafo(g);
    	 
     	return EXIT_SUCCESS;
 	}
 	return EXIT_FAILURE;
-}
\ No newline at end of file
+}
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdbool.h>
+
+#include "grafo_csr.h"
+#include "leitura_grafo.h"
+#include "hierarquia_contracao.h"
+#include "cronometro.h"
+
+// Pré-processa um grafo ponderado (texto ou binário) numa hierarquia de contração, usada pelo dijkstra -H
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Uso: %s entrada.graph saida.hch\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *entrada = argv[1], *saida = argv[2];
+    int fd = open(entrada, O_RDONLY);
+
+    if (fd < 0) {
+        perror(entrada);
+        return EXIT_FAILURE;
+    }
+
+    GrafoCSR *g = carregar_grafo(fd, true);
+    close(fd);
+
+    if (!g) {
+        fprintf(stderr, "Não foi possível ler o grafo de %s.\n", entrada);
+        return EXIT_FAILURE;
+    }
+    if (possui_peso_negativo(g)) {
+        fprintf(stderr, "A hierarquia de contração exige pesos não negativos.\n");
+        desalocar_grafo_csr(g);
+        return EXIT_FAILURE;
+    }
+
+    double inicio = tempo_atual();
+    HierarquiaContracao *H = construir_hierarquia(g, true);
+    double fim = tempo_atual();
+
+    if (!H) {
+        fprintf(stderr, "Memória insuficiente para a hierarquia de contração.\n");
+        desalocar_grafo_csr(g);
+        return EXIT_FAILURE;
+    }
+
+    FILE *arq = fopen(saida, "wb");
+    int ok = arq != NULL;
+
+    if (ok) {
+        ok = gravar_hierarquia(H, arq);
+        ok = (fclose(arq) == 0) && ok;
+    }
+
+    int atalhos = 0;
+    for (int e = 0; e < H->qtd_arcos_subida; e++)
+        atalhos += H->meio_subida[e] != -1;
+    for (int e = 0; e < H->qtd_arcos_descida; e++)
+        atalhos += H->meio_descida[e] != -1;
+
+    if (ok)
+        printf("%s: %d vértices, %d arcos -> %s: %d arcos de subida e %d de descida (%d atalhos), %.1f s\n",
+               entrada, g->qtd_vertices, g->qtd_arcos, saida, H->qtd_arcos_subida, H->qtd_arcos_descida,
+               atalhos, fim - inicio);
+    else
+        perror(saida);
+
+    desalocar_hierarquia(H);
+    desalocar_grafo_csr(g);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
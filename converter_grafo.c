@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdbool.h>
+
+#include "grafo_csr.h"
+#include "leitura_grafo.h"
+
+// Converte um grafo no formato texto (.graph) para o formato binário lido com mmap pelos programas
+int main(int argc, char *argv[]) {
+    bool sem_pesos = argc > 1 && strcmp(argv[1], "-s") == 0;
+
+    if (argc - sem_pesos != 3) {
+        fprintf(stderr, "Uso: %s [-s] entrada.graph saida.bgraph\n", argv[0]);
+        fprintf(stderr, "  -s  grava o grafo sem pesos (para DFS, BFS e componentes)\n");
+        return EXIT_FAILURE;
+    }
+
+    const char *entrada = argv[1 + sem_pesos], *saida = argv[2 + sem_pesos];
+    int fd = open(entrada, O_RDONLY);
+
+    if (fd < 0) {
+        perror(entrada);
+        return EXIT_FAILURE;
+    }
+
+    GrafoCSR *g = carregar_grafo(fd, !sem_pesos);
+    close(fd);
+
+    if (!g) {
+        fprintf(stderr, "Não foi possível ler o grafo de %s.\n", entrada);
+        return EXIT_FAILURE;
+    }
+
+    FILE *arq = fopen(saida, "wb");
+    if (!arq) {
+        perror(saida);
+        desalocar_grafo_csr(g);
+        return EXIT_FAILURE;
+    }
+
+    GrafoCSR gravado = *g;
+    if (sem_pesos)
+        gravado.pesos = NULL;
+
+    int ok = gravar_grafo_binario(&gravado, arq);
+    ok = (fclose(arq) == 0) && ok;
+
+    if (ok)
+        printf("%s: %d vértices, %d arcos%s -> %s\n", entrada, g->qtd_vertices, g->qtd_arcos,
+               gravado.pesos ? " com pesos" : "", saida);
+    else
+        fprintf(stderr, "Erro ao gravar %s.\n", saida);
+
+    desalocar_grafo_csr(g);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
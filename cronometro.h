@@ -0,0 +1,14 @@
+#ifndef CRONOMETRO_H
+#define CRONOMETRO_H
+
+#include <time.h>
+
+// Tempo monotônico em segundos, para medir trechos dos algoritmos
+static inline double tempo_atual(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+#endif
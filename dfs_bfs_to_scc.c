@@ -1,8 +1,26 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <stdbool.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "grafo_csr.h"
+#include "leitura_grafo.h"
+#include "ordem_topologica.h"
+#include "ordem_dinamica.h"
+#include "cronometro.h"
+
+// Com -q os modos que aceitam a opção não exibem os passos nem o resultado vértice a vértice, só o tempo
+static bool verboso = true;
+
 #define BRANCO 'b'
 #define PRETO 'p'
 #define CINZA 'c'
@@ -16,13 +34,14 @@ typedef struct No {
 typedef struct Vertice {
     char cor;
     int td, tf, d;
-    No *lista_adjacencia;
     struct Vertice *pai;
 } Vertice;
 
 typedef struct Grafo {
     int qtd_vertices;
     Vertice *grafo;
+    GrafoCSR *adj;  // vizinhos de u em adj->vizinhos[adj->inicio[u]] ... adj->vizinhos[adj->inicio[u + 1] - 1]
+    GrafoCSR *adj_entrada;  // arcos invertidos (só em grafos dirigidos), montados na primeira vez que são usados
 } Grafo;
 
 
@@ -37,18 +56,19 @@ No *criar_no_adjacente(int vertice) {  // "vertice" é a posição do vértice v
     return NULL;
 }
 
-Grafo *criar_grafo(int qtd_vertices) {
+Grafo *criar_grafo(GrafoCSR *adj) {  // O grafo passa a ser dono de adj
+    if (!adj)
+        return NULL;
+
     Grafo *g = (Grafo*) malloc(sizeof(Grafo));
 
     if (g) {
-        g->grafo = (Vertice*) malloc(qtd_vertices * sizeof(Vertice));
+        g->grafo = (Vertice*) malloc(adj->qtd_vertices * sizeof(Vertice));
 
         if (g->grafo) {
-            g->qtd_vertices = qtd_vertices;
-
-            for (int i = 0; i < qtd_vertices; i++) 
-                g->grafo[i].lista_adjacencia = NULL;
-            
+            g->qtd_vertices = adj->qtd_vertices;
+            g->adj = adj;
+            g->adj_entrada = NULL;
             return g;
         }
     }
@@ -56,23 +76,14 @@ Grafo *criar_grafo(int qtd_vertices) {
     if (g)
         free(g);
 
+    desalocar_grafo_csr(adj);
     return NULL;
 }
 
 void desalocar_grafo(Grafo *g) {
     if (g) {
-        No *no_atual = NULL, *prox = NULL;
-
-        for (int i = 0; i < g->qtd_vertices; i++) {
-            no_atual = g->grafo[i].lista_adjacencia;
-
-            while (no_atual) {
-                prox = no_atual->proximo_no;
-                free(no_atual);
-                no_atual = prox;
-            }
-        }
-
+        desalocar_grafo_csr(g->adj);
+        desalocar_grafo_csr(g->adj_entrada);
         free(g->grafo);
         free(g);
     }
@@ -81,112 +92,121 @@ void desalocar_grafo(Grafo *g) {
 void exibir_grafo(Grafo *g) {
 
     if (g) {
-        No *no_atual = NULL;
-
         for (int i = 0; i < g->qtd_vertices; i++) {
-            no_atual = g->grafo[i].lista_adjacencia;
             printf("\n [%d]", i);
 
-            while (no_atual) {
-                printf(" ~> %d", no_atual->vertice);
-                no_atual = no_atual->proximo_no;
-            }
+            for (int e = g->adj->inicio[i]; e < g->adj->inicio[i + 1]; e++)
+                printf(" ~> %d", g->adj->vizinhos[e]);
         }
         printf("\n");
     }
 }
 
-int aresta_existe(Grafo *g, int u, int v) {
+void inserir_no_final(No **cabeca, No *novo_no) {
+    if (cabeca && novo_no) {
 
-    No *no_atual = g->grafo[u].lista_adjacencia;
-    
-    // Percorre a lista de adjacência de u para verificar se v já está nela
-    while (no_atual) {
-        if (no_atual->vertice == v)
-            return 1; // Aresta incidente de u para v já existe   
-        no_atual = no_atual->proximo_no;
-    }
+        // Lista vazia
+        if (!*cabeca) {
+            *cabeca = novo_no;
+        } else { // Lista não vazia
+            No *temp = *cabeca;
 
-    return 0; // Aresta incidente de u para v não existe
+            while (temp->proximo_no)
+                temp = temp->proximo_no; // Procurando o último nó
+        
+            temp->proximo_no = novo_no; // Inserindo no final da lista
+        }
+    }
 }
 
-void inserir_aresta(Grafo *g, int eh_grafo_dirigido, int u, int v) {
-    // Adiciona a aresta (u, v), se ela não existir
+int remover_no_inicio(No **cabeca) {
+    if (!*cabeca || !cabeca)
+        return -1; // Tentativa de remoção de fila vazia ou o ponteiro é inválido
 
-    if (!aresta_existe(g, u, v)) {
-        No *novo_no = criar_no_adjacente(v);
+    No *temp = *cabeca;
 
-        if (novo_no) {
-            novo_no->proximo_no = g->grafo[u].lista_adjacencia;
-            g->grafo[u].lista_adjacencia = novo_no;
+    int no_removido = temp->vertice;
 
-            if (!eh_grafo_dirigido) {
-                if (u != v && !aresta_existe(g, v, u)) { // !aresta_existe(g, v, u)
-                    // Adiciona a aresta (v, u) também para o caso particular de grafo simples
-                    novo_no = criar_no_adjacente(u);
+    *cabeca = temp->proximo_no; // Atualiza a cabeça da lista para o próximo nó
+    free(temp);                // Desaloca o nó removido
 
-                    if (novo_no) {
-                        novo_no->proximo_no = g->grafo[v].lista_adjacencia;
-                        g->grafo[v].lista_adjacencia = novo_no;
-                    }
-                }
-            }
-        }
-    }
+    return no_removido; // Retorna o nó removido
 }
 
-void visita_dfs(Grafo *g, int u, int *tempo) {
-    printf("O vértice %d tem cor '%c'\n", u, g->grafo[u].cor);
+// Um quadro da pilha da DFS: o vértice e a posição do próximo arco dele a examinar
+typedef struct QuadroDFS {
+    int u;
+    int e;
+} QuadroDFS;
+
+/*
+ * Visita em profundidade a partir de u sem recursão, para não estourar a pilha do C em caminhos
+ * longos. Cada quadro guarda onde parou a varredura dos vizinhos, então os vértices são
+ * descobertos e finalizados na mesma ordem da versão recursiva, com os mesmos td, tf e pai.
+ * pilha precisa ter espaço para qtd_vertices quadros.
+ */
+void visita_dfs_iterativa(Grafo *g, int u, int *tempo, QuadroDFS *pilha, bool rastrear) {
+    const GrafoCSR *adj = g->adj;
+    int topo = 0;
+
+    if (rastrear)
+        printf("O vértice %d tem cor '%c'\n", u, g->grafo[u].cor);
 
     (*tempo)++;
     g->grafo[u].td = *tempo;
     g->grafo[u].cor = CINZA;
-    
-    printf("Descobrindo o vértice %d, agora de cor '%c', sendo seu tempo de descoberta td = %d\n", 
-    u, g->grafo[u].cor, g->grafo[u].td);
-
-    No *v = g->grafo[u].lista_adjacencia;
+    pilha[topo++] = (QuadroDFS) { u, adj->inicio[u] };
 
-    printf("A exploração dos vértices vizinhos do vértice %d será iniciada.\n", u);
-
-    while (v) {
-        if (g->grafo[v->vertice].cor == BRANCO) {
-            g->grafo[v->vertice].pai = &(g->grafo[u]);
-            visita_dfs(g, v->vertice, tempo);
-        }
-        v = v->proximo_no;
+    if (rastrear) {
+        printf("Descobrindo o vértice %d, agora de cor '%c', sendo seu tempo de descoberta td = %d\n", 
+        u, g->grafo[u].cor, g->grafo[u].td);
+        printf("A exploração dos vértices vizinhos do vértice %d será iniciada.\n", u);
     }
 
-    g->grafo[u].cor = PRETO;
-    (*tempo)++;
-    g->grafo[u].tf = *tempo;
+    while (topo > 0) {
+        QuadroDFS *quadro = &pilha[topo - 1];
+        int x = quadro->u, fim = adj->inicio[x + 1];
 
-    printf("O vértice %d foi totalmente processado, tendo tempo de finalização tf = %d e agora cor '%c'\n",
-    u, g->grafo[u].tf, g->grafo[u].cor);
-}
+        while (quadro->e < fim && g->grafo[adj->vizinhos[quadro->e]].cor != BRANCO)
+            quadro->e++;
 
-void busca_em_profundidade(Grafo *g) {
-    printf("Grafo de entrada:\n");
-    exibir_grafo(g);
+        if (quadro->e < fim) {
+            // Desce para o próximo vizinho branco; a varredura de x continua do arco seguinte
+            int v = adj->vizinhos[quadro->e++];
 
-    printf("\n");
-    printf("INICIANDO A BUSCA EM PROFUNDIDADE\n\n");
+            g->grafo[v].pai = &(g->grafo[x]);
+            if (rastrear)
+                printf("O vértice %d tem cor '%c'\n", v, g->grafo[v].cor);
 
-    for (int i = 0; i < g->qtd_vertices; i++) {
-        g->grafo[i].cor = BRANCO;
-        g->grafo[i].pai = NULL;
-        printf("O vértice %d recebeu cor '%c' e tem pai desconhecido\n", i, g->grafo[i].cor);
-    }
+            (*tempo)++;
+            g->grafo[v].td = *tempo;
+            g->grafo[v].cor = CINZA;
+            pilha[topo++] = (QuadroDFS) { v, adj->inicio[v] };
 
-    int tempo = 0;
+            if (rastrear) {
+                printf("Descobrindo o vértice %d, agora de cor '%c', sendo seu tempo de descoberta td = %d\n", 
+                v, g->grafo[v].cor, g->grafo[v].td);
+                printf("A exploração dos vértices vizinhos do vértice %d será iniciada.\n", v);
+            }
+            continue;
+        }
 
-    printf("\nComeçando a vista de vértices brancos\n");
-    for (int i = 0; i < g->qtd_vertices; i++)
-        if (g->grafo[i].cor == BRANCO)
-            visita_dfs(g, i, &tempo);
+        topo--;
+        g->grafo[x].cor = PRETO;
+        (*tempo)++;
+        g->grafo[x].tf = *tempo;
 
-    printf("\nBUSCA EM PROFUNDIDADE ENCERRADA\n\n\n");
+        if (rastrear)
+            printf("O vértice %d foi totalmente processado, tendo tempo de finalização tf = %d e agora cor '%c'\n",
+            x, g->grafo[x].tf, g->grafo[x].cor);
+    }
+}
 
+void visita_dfs(Grafo *g, int u, int *tempo, QuadroDFS *pilha) {
+    visita_dfs_iterativa(g, u, tempo, pilha, verboso);
+}
+
+void exibir_resultado_dfs(Grafo *g) {
     printf("Resultado final do algoritmo de busca em profundidade:\n\n");
 
     for (int i = 0; i < g->qtd_vertices; i++) {
@@ -197,51 +217,45 @@ void busca_em_profundidade(Grafo *g) {
     printf("\n\n");
 }
 
-void inserir_no_final(No **cabeca, No *novo_no) {
-    if (cabeca && novo_no) {
+// Retorna false se faltar memória para a pilha
+bool busca_em_profundidade(Grafo *g) {
+    QuadroDFS *pilha = (QuadroDFS*) malloc(g->qtd_vertices * sizeof(QuadroDFS));
 
-        // Lista vazia
-        if (!*cabeca) {
-            *cabeca = novo_no;
-        } else { // Lista não vazia
-            No *temp = *cabeca;
-
-            while (temp->proximo_no)
-                temp = temp->proximo_no; // Procurando o último nó
-        
-            temp->proximo_no = novo_no; // Inserindo no final da lista
-        }
-    }
-}
+    if (!pilha)
+        return false;
 
-void inserir_no_inicio(No **cabeca, No *novo_no) {
-    if (cabeca && novo_no) {
+    if (verboso) {
+        printf("Grafo de entrada:\n");
+        exibir_grafo(g);
 
-        // Lista vazia
-        if (!*cabeca) {
-            *cabeca = novo_no;
-        } else { // Lista não vazia
-            novo_no->proximo_no = *cabeca;
-            *cabeca = novo_no;
-        }
+        printf("\n");
+        printf("INICIANDO A BUSCA EM PROFUNDIDADE\n\n");
     }
-}
 
-int remover_no_inicio(No **cabeca) {
-    if (!*cabeca || !cabeca)
-        return -1; // Tentativa de remoção de fila vazia ou o ponteiro é inválido
+    for (int i = 0; i < g->qtd_vertices; i++) {
+        g->grafo[i].cor = BRANCO;
+        g->grafo[i].pai = NULL;
+        if (verboso)
+            printf("O vértice %d recebeu cor '%c' e tem pai desconhecido\n", i, g->grafo[i].cor);
+    }
 
-    No *temp = *cabeca;
+    int tempo = 0;
 
-    int no_removido = temp->vertice;
+    if (verboso)
+        printf("\nComeçando a vista de vértices brancos\n");
+    for (int i = 0; i < g->qtd_vertices; i++)
+        if (g->grafo[i].cor == BRANCO)
+            visita_dfs(g, i, &tempo, pilha);
 
-    *cabeca = temp->proximo_no; // Atualiza a cabeça da lista para o próximo nó
-    free(temp);                // Desaloca o nó removido
+    free(pilha);
 
-    return no_removido; // Retorna o nó removido
+    if (verboso) {
+        printf("\nBUSCA EM PROFUNDIDADE ENCERRADA\n\n\n");
+        exibir_resultado_dfs(g);
+    }
+    return true;
 }
 
-
 void busca_em_largura(Grafo *g, int s) {
     printf("Grafo de entrada:\n");
     exibir_grafo(g);
@@ -277,21 +291,20 @@ void busca_em_largura(Grafo *g, int s) {
         int u = remover_no_inicio(&Q);
         printf("Retirando o vértice %d de cor '%c' para processamento.\n", u, g->grafo[u].cor);
 
-        // Preparativo para explorar a lista de adjacência de u
-        No *v = g->grafo[u].lista_adjacencia;
+        // Explorando a lista de adjacência de u
+        for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+            int v = g->adj->vizinhos[e];
 
-        while (v) {
-            if (g->grafo[v->vertice].cor == BRANCO) {           // Vizinho ainda não visitado
-                g->grafo[v->vertice].cor = CINZA;              // Descoberto, mas ainda não completamente explorado
-                g->grafo[v->vertice].d = g->grafo[u].d + 1;   // Distância da fonte até vizinho é a distância até u + 1
-                g->grafo[v->vertice].pai = &g->grafo[u];     // O pai do vizinho é u
+            if (g->grafo[v].cor == BRANCO) {           // Vizinho ainda não visitado
+                g->grafo[v].cor = CINZA;              // Descoberto, mas ainda não completamente explorado
+                g->grafo[v].d = g->grafo[u].d + 1;   // Distância da fonte até vizinho é a distância até u + 1
+                g->grafo[v].pai = &g->grafo[u];     // O pai do vizinho é u
 
                 printf("Adicionando na fila o vértice vizinho %d, cuja cor agora é '%c', está a uma distância %d do vértice fonte e possui como pai o vértice %d\n", 
-                v->vertice, g->grafo[v->vertice].cor, g->grafo[v->vertice].d, u);
+                v, g->grafo[v].cor, g->grafo[v].d, u);
                 // Adicionar o vizinho na fila para processar depois
-                inserir_no_final(&Q, criar_no_adjacente(v->vertice));
+                inserir_no_final(&Q, criar_no_adjacente(v));
             }
-            v = v->proximo_no;
         }
 
         // O vértice u neste ponto fica 100% explorado 
@@ -311,213 +324,1162 @@ void busca_em_largura(Grafo *g, int s) {
     printf("\n\n");
 }
 
-Grafo *transpor_grafo(Grafo *g) {
-    Grafo *g_transposto = criar_grafo(g->qtd_vertices);
+/*
+ * BFS com otimização de direção (Beamer, Asanović e Patterson). As fronteiras são arranjos de
+ * vértices e os visitados ficam num mapa de bits, sem nenhuma alocação por vértice. Cada nível
+ * é expandido de um de dois jeitos:
+ *
+ *   de cima para baixo  cada vértice da fronteira percorre os seus arcos de saída e reivindica
+ *                       os vizinhos não visitados (a BFS comum com fila)
+ *   de baixo para cima  cada vértice não visitado percorre os seus arcos de entrada até achar um
+ *                       que venha da fronteira (marcada num mapa de bits) e para no primeiro
+ *
+ * Quando a fronteira fica grande (os arcos que saem dela passam de 1/ALFA_DIRECAO dos arcos
+ * que saem dos vértices não visitados), os passos de baixo para cima olham bem menos arcos;
+ * quando ela volta a encolher (menos de 1/BETA_DIRECAO dos vértices), a BFS volta para o
+ * sentido comum. Nos grafos de diâmetro pequeno, a maior parte dos arcos está em um ou dois
+ * níveis, que são justamente os feitos de baixo para cima.
+ *
+ * d é a mesma da busca_em_largura(). Nos passos de cima para baixo a fronteira é percorrida na
+ * ordem da fila, então pai também é o mesmo; nos de baixo para cima, pai é o primeiro vizinho
+ * de entrada na fronteira, que também está a distância d - 1, mas pode não ser o que a fila
+ * teria escolhido.
+ */
+
+#define ALFA_DIRECAO 14
+#define BETA_DIRECAO 24
+
+#define BIT_LIGADO(bits, v) (((bits)[(v) / 64] >> ((v) % 64)) & 1)
+#define LIGAR_BIT(bits, v) ((bits)[(v) / 64] |= 1ull << ((v) % 64))
+
+// Arcos de entrada de cada vértice: o próprio grafo se ele não for dirigido, senão o transposto (montado uma vez)
+const GrafoCSR *arcos_de_entrada(Grafo *g) {
+    if (!g->adj->eh_dirigido)
+        return g->adj;
+    if (!g->adj_entrada)
+        g->adj_entrada = transpor_grafo_csr(g->adj);
+    return g->adj_entrada;
+}
 
-    if (g_transposto) {
-        No *v = NULL;
+// Retorna a quantidade de vértices alcançados; com otimizar_direcao = false todos os passos são de cima para baixo
+int bfs_vetorial(Grafo *g, int s, bool otimizar_direcao) {
+    int n = g->qtd_vertices, palavras = (n + 63) / 64;
+    const GrafoCSR *adj = g->adj, *entrada = otimizar_direcao ? arcos_de_entrada(g) : NULL;
+    int *fronteira = (int *) malloc(n * sizeof(int));
+    int *proxima = (int *) malloc(n * sizeof(int));
+    uint64_t *visitado = (uint64_t *) calloc(palavras, sizeof(uint64_t));
+    uint64_t *na_fronteira = (uint64_t *) malloc(palavras * sizeof(uint64_t));
 
-        for (int u = 0; u < g->qtd_vertices; u++) {
-            v = g->grafo[u].lista_adjacencia;
+    assert(fronteira && proxima && visitado && na_fronteira && (!otimizar_direcao || entrada));
 
-            while (v) {
-                inserir_aresta(g_transposto, 1, v->vertice, u);  // Inverte a direção da aresta
-                v = v->proximo_no;
+    for (int i = 0; i < n; i++) {
+        g->grafo[i].cor = BRANCO;
+        g->grafo[i].d = -1;
+        g->grafo[i].pai = NULL;
+    }
+
+    g->grafo[s].d = 0;
+    LIGAR_BIT(visitado, s);
+    fronteira[0] = s;
+
+    int tam_fronteira = 1, alcancados = 1;
+    long arcos_fronteira = grau_saida(adj, s), arcos_nao_visitados = adj->qtd_arcos - grau_saida(adj, s);
+    bool baixo_para_cima = false;
+
+    for (int nivel = 0; tam_fronteira > 0; nivel++) {
+        int tam_proxima = 0;
+        long arcos_proxima = 0;
+
+        if (otimizar_direcao) {
+            if (!baixo_para_cima && arcos_fronteira > arcos_nao_visitados / ALFA_DIRECAO)
+                baixo_para_cima = true;
+            else if (baixo_para_cima && tam_fronteira < n / BETA_DIRECAO)
+                baixo_para_cima = false;
+        }
+
+        if (baixo_para_cima) {
+            memset(na_fronteira, 0, palavras * sizeof(uint64_t));
+            for (int i = 0; i < tam_fronteira; i++)
+                LIGAR_BIT(na_fronteira, fronteira[i]);
+
+            for (int w = 0; w < palavras; w++) {
+                if (visitado[w] == ~0ull)
+                    continue;   // 64 vértices já visitados de uma vez
+
+                for (int v = w * 64; v < n && v < (w + 1) * 64; v++) {
+                    if (BIT_LIGADO(visitado, v))
+                        continue;
+
+                    for (int e = entrada->inicio[v]; e < entrada->inicio[v + 1]; e++) {
+                        int u = entrada->vizinhos[e];
+
+                        if (BIT_LIGADO(na_fronteira, u)) {
+                            LIGAR_BIT(visitado, v);
+                            g->grafo[v].d = nivel + 1;
+                            g->grafo[v].pai = &g->grafo[u];
+                            proxima[tam_proxima++] = v;
+                            arcos_proxima += grau_saida(adj, v);
+                            break;
+                        }
+                    }
+                }
+            }
+        } else {
+            for (int i = 0; i < tam_fronteira; i++) {
+                int u = fronteira[i];
+
+                for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++) {
+                    int v = adj->vizinhos[e];
+
+                    if (!BIT_LIGADO(visitado, v)) {
+                        LIGAR_BIT(visitado, v);
+                        g->grafo[v].d = nivel + 1;
+                        g->grafo[v].pai = &g->grafo[u];
+                        proxima[tam_proxima++] = v;
+                        arcos_proxima += grau_saida(adj, v);
+                    }
+                }
             }
         }
-        return g_transposto;
+
+        int *aux = fronteira;
+        fronteira = proxima;
+        proxima = aux;
+        tam_fronteira = tam_proxima;
+        arcos_fronteira = arcos_proxima;
+        arcos_nao_visitados -= arcos_proxima;
+        alcancados += tam_proxima;
     }
-    return NULL;
-}
 
-void exibir_ordenacao_topologica(No *lista_ordenada) {
-    printf("Resultado final da ordenação topológica:\n\n");
-    
-    No *atual = lista_ordenada;
+    for (int i = 0; i < n; i++)
+        if (BIT_LIGADO(visitado, i))
+            g->grafo[i].cor = PRETO;
 
-    printf("[L]");
-    while (atual) {
-        printf(" ~> %d", atual->vertice);
-        atual = atual->proximo_no;
-    }
+    free(fronteira);
+    free(proxima);
+    free(visitado);
+    free(na_fronteira);
+    return alcancados;
+}
 
-    printf("\n");
+/*
+ * BFS paralela sincronizada por níveis. Cada nível é dividido entre as threads pelo espaço dos
+ * arcos que saem da fronteira, e não pelos vértices: com a soma de prefixos dos graus, o índice
+ * global k de um arco leva ao vértice da fronteira dono dele por busca binária. Assim um vértice
+ * de grau enorme (comum nos grafos de lei de potência) é repartido como qualquer outra faixa.
+ *
+ * Cada thread começa com uma faixa contígua de arcos e tira dela pedaços de PEDACO_BFS arcos.
+ * Quando a sua acaba, ela rouba a metade final da faixa de outra thread. A faixa (início, fim)
+ * de cada thread fica numa palavra de 64 bits: a dona avança o início e o ladrão recua o fim,
+ * os dois por compare-and-swap, então um pedaço nunca é entregue duas vezes.
+ *
+ * Um vértice é reivindicado por um fetch-or atômico no mapa de bits dos visitados; só a thread
+ * que ligou o bit grava d e pai e coloca o vértice na sua fila local. No fim do nível as filas
+ * locais são concatenadas na próxima fronteira. d é exatamente a da BFS comum; pai é sempre um
+ * vizinho de entrada a distância d - 1, mas depende de qual thread chegou primeiro.
+ */
+
+#define PEDACO_BFS 256
+
+typedef struct FaixaArcos {
+    uint64_t faixa;   // início nos 32 bits de baixo, fim nos de cima
+    char enchimento[56];   // uma faixa por linha de cache
+} FaixaArcos;
+
+static inline uint64_t montar_faixa(uint32_t ini, uint32_t fim) {
+    return (uint64_t) fim << 32 | ini;
 }
 
-void visita_dfs_topologica(Grafo *g, int u, int *tempo, No **lista_ordenada) {
-    printf("O vértice %d tem cor '%c'\n", u, g->grafo[u].cor);
+// A dona tira um pedaço do início da sua faixa
+static bool pegar_pedaco(FaixaArcos *f, uint32_t *a, uint32_t *b) {
+    uint64_t atual = __atomic_load_n(&f->faixa, __ATOMIC_ACQUIRE);
 
-    (*tempo)++;
-    g->grafo[u].td = *tempo;
-    g->grafo[u].cor = CINZA;
-    
-    printf("Descobrindo o vértice %d, agora de cor '%c', sendo seu tempo de descoberta td = %d\n", 
-    u, g->grafo[u].cor, g->grafo[u].td);
+    for (;;) {
+        uint32_t ini = (uint32_t) atual, fim = (uint32_t) (atual >> 32);
 
-    No *v = g->grafo[u].lista_adjacencia;
+        if (ini >= fim)
+            return false;
 
-    printf("A exploração dos vértices vizinhos do vértice %d será iniciada.\n", u);
+        uint32_t novo_ini = fim - ini > PEDACO_BFS ? ini + PEDACO_BFS : fim;
 
-    while (v) {
-        if (g->grafo[v->vertice].cor == BRANCO) {
-            g->grafo[v->vertice].pai = &(g->grafo[u]);
-            visita_dfs_topologica(g, v->vertice, tempo, lista_ordenada);
+        if (__atomic_compare_exchange_n(&f->faixa, &atual, montar_faixa(novo_ini, fim), false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *a = ini;
+            *b = novo_ini;
+            return true;
         }
-        v = v->proximo_no;
     }
+}
 
-    g->grafo[u].cor = PRETO;
-    (*tempo)++;
-    g->grafo[u].tf = *tempo;
+// Um ladrão leva a metade final da faixa de outra thread (ou o resto, se for só um pedaço)
+static bool roubar_faixa(FaixaArcos *f, uint32_t *a, uint32_t *b) {
+    uint64_t atual = __atomic_load_n(&f->faixa, __ATOMIC_ACQUIRE);
 
-    printf("O vértice %d foi totalmente processado, tendo tempo de finalização tf = %d e agora cor '%c'\n",
-    u, g->grafo[u].tf, g->grafo[u].cor);
+    for (;;) {
+        uint32_t ini = (uint32_t) atual, fim = (uint32_t) (atual >> 32);
 
+        if (ini >= fim)
+            return false;
 
-    // Coloca o vértice u no início da lista topológica (ordena em ordem inversa de finalzação)
-    printf("Inserindo o vértice %d no início da lista topológica\n", u);
-    No *novo_no = criar_no_adjacente(u);
-    inserir_no_inicio(lista_ordenada, novo_no);
+        uint32_t meio = fim - ini > PEDACO_BFS ? ini + (fim - ini) / 2 : ini;
+
+        if (__atomic_compare_exchange_n(&f->faixa, &atual, montar_faixa(ini, meio), false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *a = meio;
+            *b = fim;
+            return true;
+        }
+    }
 }
 
-No *ordenacao_topologica(Grafo *g) {
-    printf("Grafo de entrada:\n");
-    exibir_grafo(g);
-    printf("\n");
+typedef struct FilaLocal {
+    int *vertices;
+    int tam, capacidade;
+} FilaLocal;
 
-    printf("INICIANDO A BUSCA EM PROFUNDIDADE\n\n");
-    for (int i = 0; i < g->qtd_vertices; i++) {
-        g->grafo[i].cor = BRANCO;
-        g->grafo[i].pai = NULL;
-        printf("O vértice %d recebeu cor '%c' e tem pai desconhecido\n", i, g->grafo[i].cor);
+static void inserir_fila_local(FilaLocal *f, int v) {
+    if (f->tam == f->capacidade) {
+        f->capacidade = f->capacidade ? 2 * f->capacidade : 1024;
+        f->vertices = (int *) realloc(f->vertices, f->capacidade * sizeof(int));
+        assert(f->vertices != NULL);
     }
+    f->vertices[f->tam++] = v;
+}
 
-    No *lista_ordenada = NULL;
-    int tempo = 0;
+// Percorre os arcos [a, b) da fronteira; inicio_arcos é a soma de prefixos dos graus (tam_fronteira + 1 posições)
+static void explorar_arcos(Grafo *g, const int *fronteira, const long *inicio_arcos, int tam_fronteira,
+                           uint64_t *visitado, int nivel, uint32_t a, uint32_t b, FilaLocal *saida) {
+    const GrafoCSR *adj = g->adj;
 
-    printf("\nComeçando a vista de vértices brancos\n");
-    for (int i = 0; i < g->qtd_vertices; i++)
-        if (g->grafo[i].cor == BRANCO)
-            visita_dfs_topologica(g, i, &tempo, &lista_ordenada);
+    // Último i com inicio_arcos[i] <= a: o vértice da fronteira dono do arco a
+    int esq = 0, dir = tam_fronteira - 1;
+    while (esq < dir) {
+        int meio = esq + (dir - esq + 1) / 2;
 
-    printf("\nBUSCA EM PROFUNDIDADE ENCERRADA\n\n\n");
+        if (inicio_arcos[meio] <= a)
+            esq = meio;
+        else
+            dir = meio - 1;
+    }
 
+    for (int i = esq; i < tam_fronteira && inicio_arcos[i] < b; i++) {
+        int u = fronteira[i];
+        long primeiro = inicio_arcos[i] > a ? inicio_arcos[i] : a;
+        long ultimo = inicio_arcos[i + 1] < b ? inicio_arcos[i + 1] : b;
 
-    printf("Resultado final do algoritmo de busca em profundidade:\n\n");
+        for (long k = primeiro; k < ultimo; k++) {
+            int v = adj->vizinhos[adj->inicio[u] + (k - inicio_arcos[i])];
+            uint64_t bit = 1ull << (v % 64);
+
+            if ((__atomic_load_n(&visitado[v / 64], __ATOMIC_RELAXED) & bit) ||
+                (__atomic_fetch_or(&visitado[v / 64], bit, __ATOMIC_RELAXED) & bit))
+                continue;
+
+            g->grafo[v].d = nivel + 1;
+            g->grafo[v].pai = &g->grafo[u];
+
+            inserir_fila_local(saida, v);
+        }
+    }
+}
+
+// Retorna a quantidade de vértices alcançados
+int bfs_paralela(Grafo *g, int s) {
+    int n = g->qtd_vertices, palavras = (n + 63) / 64, qtd_threads = 1;
+#ifdef _OPENMP
+    qtd_threads = omp_get_max_threads();
+#endif
+    int *fronteira = (int *) malloc(n * sizeof(int));
+    int *proxima = (int *) malloc(n * sizeof(int));
+    long *inicio_arcos = (long *) malloc((n + 1) * sizeof(long));
+    uint64_t *visitado = (uint64_t *) calloc(palavras, sizeof(uint64_t));
+    FaixaArcos *faixas = (FaixaArcos *) aligned_alloc(64, qtd_threads * sizeof(FaixaArcos));
+    int *desloc = (int *) malloc((qtd_threads + 1) * sizeof(int));
+
+    assert(fronteira && proxima && inicio_arcos && visitado && faixas && desloc);
+
+    int tam_fronteira = 1, alcancados = 1, nivel = 0;
+
+    #pragma omp parallel
+    {
+        int t = 0, p = 1;
+#ifdef _OPENMP
+        t = omp_get_thread_num();
+        p = omp_get_num_threads();
+#endif
+        FilaLocal saida = { NULL, 0, 0 };
+
+        #pragma omp for
+        for (int i = 0; i < n; i++) {
+            g->grafo[i].cor = BRANCO;
+            g->grafo[i].d = -1;
+            g->grafo[i].pai = NULL;
+        }
 
+        #pragma omp single
+        {
+            g->grafo[s].d = 0;
+            visitado[s / 64] |= 1ull << (s % 64);
+            fronteira[0] = s;
+        }
+
+        while (tam_fronteira > 0) {
+            #pragma omp for
+            for (int i = 0; i < tam_fronteira; i++)
+                inicio_arcos[i + 1] = grau_saida(g->adj, fronteira[i]);
+
+            #pragma omp single
+            {
+                inicio_arcos[0] = 0;
+                for (int i = 0; i < tam_fronteira; i++)
+                    inicio_arcos[i + 1] += inicio_arcos[i];
+
+                long total = inicio_arcos[tam_fronteira];
+                for (int i = 0; i < p; i++)
+                    faixas[i].faixa = montar_faixa((uint32_t) (total * i / p), (uint32_t) (total * (i + 1) / p));
+            }
+
+            uint32_t a, b;
+            for (;;) {
+                if (pegar_pedaco(&faixas[t], &a, &b)) {
+                    explorar_arcos(g, fronteira, inicio_arcos, tam_fronteira, visitado, nivel, a, b, &saida);
+                    continue;
+                }
+
+                // Sem trabalho próprio: procura uma vítima, começando pela thread seguinte
+                bool roubou = false;
+                for (int i = 1; i < p && !roubou; i++)
+                    roubou = roubar_faixa(&faixas[(t + i) % p], &a, &b);
+                if (!roubou)
+                    break;
+
+                // A faixa roubada vira a própria faixa, e pode ser roubada de novo por outras threads
+                __atomic_store_n(&faixas[t].faixa, montar_faixa(a, b), __ATOMIC_RELEASE);
+            }
+
+            desloc[t + 1] = saida.tam;
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                desloc[0] = 0;
+                for (int i = 0; i < p; i++)
+                    desloc[i + 1] += desloc[i];
+            }
+
+            memcpy(proxima + desloc[t], saida.vertices, saida.tam * sizeof(int));
+            saida.tam = 0;
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                int *aux = fronteira;
+                fronteira = proxima;
+                proxima = aux;
+                tam_fronteira = desloc[p];
+                alcancados += tam_fronteira;
+                nivel++;
+            }
+        }
+
+        free(saida.vertices);
+
+        #pragma omp for
+        for (int i = 0; i < n; i++)
+            if (g->grafo[i].d != -1)
+                g->grafo[i].cor = PRETO;
+    }
+
+    free(fronteira);
+    free(proxima);
+    free(inicio_arcos);
+    free(visitado);
+    free(faixas);
+    free(desloc);
+    return alcancados;
+}
+
+void exibir_resultado_bfs(Grafo *g) {
+    printf("Resultado final do algoritmo de busca em largura:\n\n");
     for (int i = 0; i < g->qtd_vertices; i++) {
-        printf("O vértice %d terminou com cor '%c', tendo td = %d, tf = %d e vértice pai %d\n", 
-        i, g->grafo[i].cor, g->grafo[i].td, g->grafo[i].tf, g->grafo[i].pai ? (int)(g->grafo[i].pai - g->grafo) : -1);
+        printf("O vértice %d terminou com cor '%c', distância do vértice fonte de %d e vértice pai %d\n", 
+        i, g->grafo[i].cor, g->grafo[i].d, g->grafo[i].pai ? (int)(g->grafo[i].pai - g->grafo) : -1);
     }
+    printf("\n\n");
+}
 
+void exibir_ordenacao_topologica(const OrdemTopologica *o) {
+    printf("Resultado final da ordenação topológica:\n\n");
+
+    printf("[L]");
+    for (int i = 0; i < o->qtd_ordenados; i++)
+        printf(" ~> %d", o->ordem[i]);
     printf("\n\n");
 
-    exibir_ordenacao_topologica(lista_ordenada);
+    for (int k = 0; k < o->qtd_niveis; k++) {
+        printf("Nível %d:", k);
+        for (int i = o->inicio_nivel[k]; i < o->inicio_nivel[k + 1]; i++)
+            printf(" %d", o->ordem[i]);
+        printf("\n");
+    }
+}
 
-    return lista_ordenada;
+void exibir_ciclo(const OrdemTopologica *o) {
+    printf("O grafo tem um ciclo, então não há ordenação topológica (%d de %d vértices ordenados):\n",
+           o->qtd_ordenados, o->qtd_vertices);
+    for (int i = 0; i < o->tam_ciclo; i++)
+        printf("%d -> ", o->ciclo[i]);
+    printf("%d\n", o->ciclo[0]);
 }
 
-void desalocar_lista(No *lista_ordenada) {
-    while (lista_ordenada) {
-        No *temp = lista_ordenada;
+/*
+ * Ordenação topológica por níveis (algoritmo de Kahn, em ordem_topologica.c), no lugar da DFS:
+ * não aloca um nó por vértice, dá o nível de cada vértice e, num grafo com ciclo, mostra o ciclo
+ * em vez de devolver uma ordem inválida.
+ */
+OrdemTopologica *ordenacao_topologica(Grafo *g, bool paralelo) {
+    if (verboso) {
+        printf("Grafo de entrada:\n");
+        exibir_grafo(g);
+        printf("\n");
+    }
 
-        lista_ordenada = lista_ordenada->proximo_no;
-        free(temp);
+    OrdemTopologica *o = ordenar_por_niveis(g->adj, paralelo);
+
+    if (o && verboso) {
+        if (o->tam_ciclo > 0)
+            exibir_ciclo(o);
+        else
+            exibir_ordenacao_topologica(o);
     }
+    return o;
 }
 
-void visita_dfs_componente(Grafo *g, int u, No **componente) {
-    g->grafo[u].cor = CINZA;
+/*
+ * Componentes fortemente conexas numa única DFS, pela variante do algoritmo de Tarjan de Pearce
+ * ("A space-efficient algorithm for finding strongly connected components", 2016), sem montar o
+ * grafo transposto. Em vez de td e low, cada vértice tem um único rindice: ao ser descoberto
+ * recebe o próximo índice, e depois o menor rindice alcançável pelos arcos da sua subárvore. Se
+ * ao finalizar v ele continua com o próprio índice, v é raiz de uma componente: os vértices
+ * empilhados depois dele são retirados e recebem todos o mesmo número de componente, contado
+ * para baixo a partir de n - 1 para não se confundir com os índices ainda em uso.
+ *
+ * Além de componente (que guarda os rindices durante a busca), usa só a pilha da DFS, a pilha de
+ * vértices abertos e um bit por vértice. As componentes saem numeradas de 0 a k - 1 em ordem
+ * topológica inversa: a componente 0 não tem arcos para as outras. Retorna k, ou -1 se faltar
+ * memória.
+ */
+int cfcs(const GrafoCSR *adj, int *componente) {
+    int n = adj->qtd_vertices, palavras = (n + 63) / 64;
+    int *rindice = componente;
+    QuadroDFS *pilha_dfs = (QuadroDFS*) malloc(n * sizeof(QuadroDFS));
+    int *pilha = (int*) malloc(n * sizeof(int));
+    uint64_t *raiz = (uint64_t*) calloc(palavras > 0 ? palavras : 1, sizeof(uint64_t));
+
+    if (!pilha_dfs || !pilha || !raiz) {
+        free(pilha_dfs);
+        free(pilha);
+        free(raiz);
+        return -1;
+    }
+
+    for (int v = 0; v < n; v++)
+        rindice[v] = -1;
+
+    int indice = 0, c = n - 1, topo = 0;
+
+    for (int s = 0; s < n; s++) {
+        if (rindice[s] != -1)
+            continue;
+
+        int topo_dfs = 0;
 
-    No *v = g->grafo[u].lista_adjacencia;
-    while (v) {
-        if (g->grafo[v->vertice].cor == BRANCO) {
-            visita_dfs_componente(g, v->vertice, componente);
+        rindice[s] = indice++;
+        LIGAR_BIT(raiz, s);
+        pilha_dfs[topo_dfs++] = (QuadroDFS) { s, adj->inicio[s] };
+
+        while (topo_dfs > 0) {
+            QuadroDFS *quadro = &pilha_dfs[topo_dfs - 1];
+            int v = quadro->u, fim = adj->inicio[v + 1];
+            bool desceu = false;
+
+            for (; quadro->e < fim; quadro->e++) {
+                int w = adj->vizinhos[quadro->e];
+
+                if (rindice[w] == -1) {
+                    quadro->e++;
+                    rindice[w] = indice++;
+                    LIGAR_BIT(raiz, w);
+                    pilha_dfs[topo_dfs++] = (QuadroDFS) { w, adj->inicio[w] };
+                    desceu = true;
+                    break;
+                }
+                if (rindice[w] < rindice[v]) {
+                    rindice[v] = rindice[w];
+                    raiz[v / 64] &= ~(1ull << (v % 64));
+                }
+            }
+            if (desceu)
+                continue;
+
+            // v finalizado
+            topo_dfs--;
+            if (BIT_LIGADO(raiz, v)) {
+                indice--;
+                while (topo > 0 && rindice[v] <= rindice[pilha[topo - 1]]) {
+                    rindice[pilha[--topo]] = c;
+                    indice--;
+                }
+                rindice[v] = c--;
+            } else
+                pilha[topo++] = v;
+
+            // O arco pai -> v termina agora: o pai herda o rindice de v, se for menor
+            if (topo_dfs > 0) {
+                int pai = pilha_dfs[topo_dfs - 1].u;
+
+                if (rindice[v] < rindice[pai]) {
+                    rindice[pai] = rindice[v];
+                    raiz[pai / 64] &= ~(1ull << (pai % 64));
+                }
+            }
         }
-        v = v->proximo_no;
     }
 
-    No *novo_no = criar_no_adjacente(u);
-    inserir_no_inicio(componente, novo_no);
+    for (int v = 0; v < n; v++)
+        componente[v] = n - 1 - rindice[v];
+
+    free(pilha_dfs);
+    free(pilha);
+    free(raiz);
+    return n - 1 - c;
+}
+
+/*
+ * Exibe as componentes, cada uma em ordem crescente de vértice. Com em_ordem_topologica (numeração
+ * do cfcs()), a última numerada vem primeiro; senão, na ordem da numeração.
+ */
+void exibir_cfcs(int qtd_vertices, const int *componente, int qtd_componentes, bool em_ordem_topologica) {
+    // Ordenação por contagem dos vértices pelo número da componente
+    int *inicio = (int*) calloc(qtd_componentes + 1, sizeof(int));
+    int *vertices = (int*) malloc(qtd_vertices * sizeof(int));
+
+    assert(inicio && vertices);
+
+    for (int v = 0; v < qtd_vertices; v++)
+        inicio[componente[v] + 1]++;
+    for (int k = 0; k < qtd_componentes; k++)
+        inicio[k + 1] += inicio[k];
+    for (int v = 0; v < qtd_vertices; v++)
+        vertices[inicio[componente[v]]++] = v;   // inicio[k] passa a ser o fim da componente k
+
+    printf("As componentes fortemente conexas são:\n\n");
+
+    for (int i = 0; i < qtd_componentes; i++) {
+        int k = em_ordem_topologica ? qtd_componentes - 1 - i : i;
+
+        printf("Componente: [ ");
+        for (int j = k > 0 ? inicio[k - 1] : 0; j < inicio[k]; j++)
+            printf("%d ", vertices[j]);
+        printf("]\n");
+    }
+
+    free(inicio);
+    free(vertices);
 }
 
-void cfcs(Grafo *g) {
-    // Primeira DFS para calcular o tf de cada vértice e já ordenar g topologicamente
-    No *lista_ordenada = ordenacao_topologica(g);
+/*
+ * Componentes fortemente conexas em paralelo, em três etapas (como no Multistep de Slota,
+ * Rajamanickam e Madduri):
+ *
+ *   1. Poda: um vértice sem arcos de entrada ou sem arcos de saída entre os que restam é sozinho
+ *      uma componente. Cada thread tira vértices assim e decrementa atomicamente os graus dos
+ *      vizinhos; quem zera um grau reivindica o vizinho e o poda também, na sua pilha local.
+ *   2. Para frente e para trás: a partir do pivô de maior grau de entrada x grau de saída, duas
+ *      buscas em largura paralelas, a segunda pelos arcos invertidos; os vértices alcançados nas
+ *      duas formam a componente do pivô, que nos grafos de lei de potência é a gigante.
+ *   3. Coloração: cada vértice restante começa com a própria cor e o maior número se propaga
+ *      pelos arcos até estabilizar. Um vértice r que manteve a própria cor é a raiz de uma
+ *      componente: os vértices de cor r que alcançam r. As buscas para trás de raízes diferentes
+ *      rodam em paralelo, e as rodadas se repetem até não restar vértice.
+ *
+ * Durante as etapas cada componente é identificada por um vértice dela; no fim são renumeradas
+ * de 0 a k - 1 na ordem do menor vértice, de modo que o resultado não depende das threads.
+ * Retorna k, ou -1 se faltar memória.
+ */
+
+typedef struct TemposCFC {
+    double poda, frente_tras, coloracao;
+    int qtd_podados, tam_gigante, rodadas_coloracao;
+} TemposCFC;
+
+#define SEM_COMPONENTE -1
+
+static bool reivindicar(int *componente, int v) {
+    int livre = SEM_COMPONENTE;
+
+    return __atomic_compare_exchange_n(&componente[v], &livre, v, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+static int podar(const GrafoCSR *adj, const GrafoCSR *entrada, int *componente, int *grau_ent, int *grau_sai) {
+    int n = adj->qtd_vertices, qtd_podados = 0;
+
+    #pragma omp parallel reduction(+:qtd_podados)
+    {
+        FilaLocal pilha = { NULL, 0, 0 };
 
-    Grafo *g_transposto = transpor_grafo(g);    
+        #pragma omp for
+        for (int v = 0; v < n; v++)
+            if ((grau_ent[v] == 0 || grau_sai[v] == 0) && reivindicar(componente, v))
+                inserir_fila_local(&pilha, v);
 
-    printf("Grafo transposto:\n");
-    exibir_grafo(g_transposto);
+        while (pilha.tam > 0) {
+            int u = pilha.vertices[--pilha.tam];
 
-    for (int i = 0; i < g_transposto->qtd_vertices; i++) {
-        g_transposto->grafo[i].cor = BRANCO;
-        g_transposto->grafo[i].pai = NULL;
+            qtd_podados++;
+            for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++) {
+                int w = adj->vizinhos[e];
+
+                if (__atomic_fetch_sub(&grau_ent[w], 1, __ATOMIC_RELAXED) == 1 && reivindicar(componente, w))
+                    inserir_fila_local(&pilha, w);
+            }
+            for (int e = entrada->inicio[u]; e < entrada->inicio[u + 1]; e++) {
+                int w = entrada->vizinhos[e];
+
+                if (__atomic_fetch_sub(&grau_sai[w], 1, __ATOMIC_RELAXED) == 1 && reivindicar(componente, w))
+                    inserir_fila_local(&pilha, w);
+            }
+        }
+        free(pilha.vertices);
     }
+    return qtd_podados;
+}
 
-    No *temp = lista_ordenada;
+/*
+ * Marca em alcancado os vértices ainda sem componente que s alcança pelos arcos de adj (BFS
+ * paralela por níveis). Se permitidos não for NULL, a busca só passa pelos vértices marcados nele.
+ */
+static void alcancar_paralelo(const GrafoCSR *adj, int s, const int *componente, const uint64_t *permitidos,
+                              uint64_t *alcancado, int *fronteira, int *proxima) {
+    int tam_fronteira = 1;
+
+    LIGAR_BIT(alcancado, s);
+    fronteira[0] = s;
+
+    while (tam_fronteira > 0) {
+        int tam_proxima = 0;
+
+        #pragma omp parallel
+        {
+            FilaLocal saida = { NULL, 0, 0 };
+
+            #pragma omp for schedule(dynamic, 64) nowait
+            for (int i = 0; i < tam_fronteira; i++) {
+                int u = fronteira[i];
+
+                for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++) {
+                    int v = adj->vizinhos[e];
+                    uint64_t bit = 1ull << (v % 64);
+
+                    // Os mapas de bits cabem melhor na cache que componente: são testados primeiro
+                    if ((__atomic_load_n(&alcancado[v / 64], __ATOMIC_RELAXED) & bit) ||
+                        (permitidos && !(permitidos[v / 64] & bit)) ||
+                        componente[v] != SEM_COMPONENTE ||
+                        (__atomic_fetch_or(&alcancado[v / 64], bit, __ATOMIC_RELAXED) & bit))
+                        continue;
+                    inserir_fila_local(&saida, v);
+                }
+            }
 
-    printf("\nAs componentes fortemente conexas são:\n\n");
+            int desloc = __atomic_fetch_add(&tam_proxima, saida.tam, __ATOMIC_RELAXED);
+            memcpy(proxima + desloc, saida.vertices, saida.tam * sizeof(int));
+            free(saida.vertices);
+        }
 
-    while (temp) {
-        int vertice = temp->vertice;
-        temp = temp->proximo_no;
-        
-        if (g_transposto->grafo[vertice].cor == BRANCO) {
-            No *componente = NULL;
+        int *aux = fronteira;
+        fronteira = proxima;
+        proxima = aux;
+        tam_fronteira = tam_proxima;
+    }
+}
 
-            visita_dfs_componente(g_transposto, vertice, &componente);
+// Retorna o tamanho da componente do pivô
+static int frente_tras(const GrafoCSR *adj, const GrafoCSR *entrada, int *componente, int *fronteira, int *proxima) {
+    int n = adj->qtd_vertices, palavras = (n + 63) / 64, pivo = -1;
+    long melhor = -1;
 
-            printf("Componente: [ ");
+    #pragma omp parallel
+    {
+        int pivo_local = -1;
+        long melhor_local = -1;
 
-            No *c = componente;
-            while (c) {
-                printf("%d ", c->vertice);
-                No *proximo = c->proximo_no;
-                free(c);
-                c = proximo;
+        #pragma omp for nowait
+        for (int v = 0; v < n; v++) {
+            long produto = (long) grau_saida(adj, v) * grau_saida(entrada, v);
+
+            if (componente[v] == SEM_COMPONENTE && produto > melhor_local) {
+                melhor_local = produto;
+                pivo_local = v;
             }
-            printf("]\n");
+        }
+
+        #pragma omp critical
+        if (melhor_local > melhor || (melhor_local == melhor && pivo_local < pivo)) {
+            melhor = melhor_local;
+            pivo = pivo_local;
+        }
+    }
+    if (pivo == -1)
+        return 0;
+
+    uint64_t *frente = (uint64_t *) calloc(palavras, sizeof(uint64_t));
+    uint64_t *tras = (uint64_t *) calloc(palavras, sizeof(uint64_t));
+    int tam = 0;
+
+    assert(frente && tras);
+
+    // Um caminho de volta de um vértice da componente até o pivô fica todo dentro dela, então a
+    // busca para trás só precisa passar pelos vértices que a busca para frente alcançou
+    alcancar_paralelo(adj, pivo, componente, NULL, frente, fronteira, proxima);
+    alcancar_paralelo(entrada, pivo, componente, frente, tras, fronteira, proxima);
+
+    #pragma omp parallel for reduction(+:tam)
+    for (int i = 0; i < palavras; i++) {
+        for (uint64_t bits = tras[i]; bits; bits &= bits - 1) {
+            componente[64 * i + __builtin_ctzll(bits)] = pivo;
+            tam++;
+        }
+    }
+
+    free(frente);
+    free(tras);
+    return tam;
+}
+
+static int colorir(const GrafoCSR *adj, const GrafoCSR *entrada, int *componente, int *cor, int *ativos) {
+    int n = adj->qtd_vertices, qtd_ativos = 0, rodadas = 0;
+
+    for (int v = 0; v < n; v++)
+        if (componente[v] == SEM_COMPONENTE)
+            ativos[qtd_ativos++] = v;
+
+    while (qtd_ativos > 0) {
+        bool mudou;
+
+        rodadas++;
+
+        #pragma omp parallel for
+        for (int i = 0; i < qtd_ativos; i++)
+            cor[ativos[i]] = ativos[i];
+
+        // Propaga a maior cor pelos arcos, atualizando no lugar, até nenhuma mudar
+        do {
+            mudou = false;
+
+            #pragma omp parallel for schedule(dynamic, 1024) reduction(||:mudou)
+            for (int i = 0; i < qtd_ativos; i++) {
+                int v = ativos[i], c = __atomic_load_n(&cor[v], __ATOMIC_RELAXED);
+
+                for (int e = adj->inicio[v]; e < adj->inicio[v + 1]; e++) {
+                    int w = adj->vizinhos[e];
+
+                    if (componente[w] != SEM_COMPONENTE)
+                        continue;
+
+                    int c_w = __atomic_load_n(&cor[w], __ATOMIC_RELAXED);
+                    while (c > c_w)
+                        if (__atomic_compare_exchange_n(&cor[w], &c_w, c, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                            mudou = true;
+                            break;
+                        }
+                }
+            }
+        } while (mudou);
+
+        // Cada raiz recolhe para trás os vértices da sua cor; só a busca da raiz r toca os vértices de cor r
+        #pragma omp parallel
+        {
+            FilaLocal pilha = { NULL, 0, 0 };
+
+            #pragma omp for schedule(dynamic, 1)
+            for (int i = 0; i < qtd_ativos; i++) {
+                int r = ativos[i];
+
+                if (cor[r] != r)
+                    continue;
+
+                componente[r] = r;
+                inserir_fila_local(&pilha, r);
+                while (pilha.tam > 0) {
+                    int u = pilha.vertices[--pilha.tam];
+
+                    for (int e = entrada->inicio[u]; e < entrada->inicio[u + 1]; e++) {
+                        int w = entrada->vizinhos[e];
+
+                        if (cor[w] == r && componente[w] == SEM_COMPONENTE) {
+                            componente[w] = r;
+                            inserir_fila_local(&pilha, w);
+                        }
+                    }
+                }
+            }
+            free(pilha.vertices);
+        }
+
+        int restantes = 0;
+        for (int i = 0; i < qtd_ativos; i++)
+            if (componente[ativos[i]] == SEM_COMPONENTE)
+                ativos[restantes++] = ativos[i];
+        qtd_ativos = restantes;
+    }
+    return rodadas;
+}
+
+int cfcs_paralela(Grafo *g, int *componente, TemposCFC *tempos) {
+    const GrafoCSR *adj = g->adj, *entrada = arcos_de_entrada(g);
+    int n = adj->qtd_vertices;
+    int *aux1 = (int *) malloc(n * sizeof(int));
+    int *aux2 = (int *) malloc(n * sizeof(int));
+    int *aux3 = (int *) malloc(n * sizeof(int));
+
+    if (!entrada || !aux1 || !aux2 || !aux3) {
+        free(aux1);
+        free(aux2);
+        free(aux3);
+        return -1;
+    }
+
+    double inicio = tempo_atual();
+
+    // Poda: aux1 e aux2 são os graus de entrada e de saída entre os vértices que restam
+    #pragma omp parallel for
+    for (int v = 0; v < n; v++) {
+        componente[v] = SEM_COMPONENTE;
+        aux1[v] = grau_saida(entrada, v);
+        aux2[v] = grau_saida(adj, v);
+    }
+    tempos->qtd_podados = podar(adj, entrada, componente, aux1, aux2);
+
+    double fim_poda = tempo_atual();
+
+    // Para frente e para trás: aux1 e aux2 são as fronteiras
+    tempos->tam_gigante = frente_tras(adj, entrada, componente, aux1, aux2);
+
+    double fim_frente_tras = tempo_atual();
+
+    // Coloração: aux1 são as cores e aux2 os vértices restantes
+    tempos->rodadas_coloracao = colorir(adj, entrada, componente, aux1, aux2);
+
+    double fim_coloracao = tempo_atual();
+
+    // Renumeração pelo menor vértice de cada componente: aux3[r] é o número novo da componente de representante r
+    int qtd_componentes = 0;
+
+    for (int v = 0; v < n; v++)
+        aux3[v] = -1;
+    for (int v = 0; v < n; v++) {
+        int r = componente[v];
+
+        if (aux3[r] == -1)
+            aux3[r] = qtd_componentes++;
+        componente[v] = aux3[r];
+    }
+
+    tempos->poda = fim_poda - inicio;
+    tempos->frente_tras = fim_frente_tras - fim_poda;
+    tempos->coloracao = fim_coloracao - fim_frente_tras;
+
+    free(aux1);
+    free(aux2);
+    free(aux3);
+    return qtd_componentes;
+}
+
+/*
+ * Ordem topológica e componentes mantidas enquanto arcos chegam pela entrada, um "u v" por linha
+ * (ordem_dinamica.c). O estado inicial vem do cfcs() sobre o grafo carregado; depois cada arco só
+ * reordena a região entre as posições das suas pontas. Uma linha "?" exibe as componentes na
+ * ordem atual. Sem -q, cada arco que muda a ordem é relatado, e um que fecha um ciclo mostra a
+ * componente formada. Retorna false se faltar memória.
+ */
+bool ordem_dinamica_da_entrada(Grafo *g, FILE *entrada) {
+    int n = g->qtd_vertices;
+    int *componente = (int*) malloc((n > 0 ? n : 1) * sizeof(int));
+    double inicio = tempo_atual();
+    int qtd_componentes = componente ? cfcs(g->adj, componente) : -1;
+    OrdemDinamica *o = qtd_componentes >= 0 ? criar_ordem_dinamica(g->adj, componente, qtd_componentes) : NULL;
+    double fim = tempo_atual();
+
+    if (!o) {
+        free(componente);
+        return false;
+    }
+
+    printf("Ordem inicial com %d vértices: %d componentes, %.3f s\n", n, qtd_componentes, fim - inicio);
+
+    int *reps = componente;   // o cfcs() já foi usado: vira espaço para exibir a ordem
+    char *linha = NULL;
+    size_t tam_linha = 0;
+    long long qtd_arcos = 0;
+    bool ok = true;
+    double tempo_insercoes = 0;
+
+    while (ok && getline(&linha, &tam_linha, entrada) != -1) {
+        int u, v;
+        char c;
+
+        if (sscanf(linha, " %c", &c) == 1 && c == '?') {
+            int k = componentes_em_ordem(o, reps);
+
+            printf("[L]");
+            for (int i = 0; i < k; i++) {
+                int r = reps[i], m = r;
+
+                if (o->tam[r] == 1) {
+                    printf(" ~> %d", r);
+                    continue;
+                }
+                printf(" ~> {");
+                do {
+                    printf(m == r ? "%d" : " %d", m);
+                    m = o->proximo_membro[m];
+                } while (m != r);
+                printf("}");
+            }
+            printf("\n");
+            continue;
+        }
+        if (sscanf(linha, "%d %d", &u, &v) != 2)
+            continue;   // linha em branco ou comentário
+        if (u < 0 || u >= n || v < 0 || v >= n) {
+            fprintf(stderr, "Arco (%d, %d) com vértice fora do intervalo [0, %d).\n", u, v, n);
+            continue;
+        }
+
+        double antes = tempo_atual();
+        ResultadoInsercao r = inserir_arco_ordem(o, u, v);
+        tempo_insercoes += tempo_atual() - antes;
+        qtd_arcos++;
+
+        if (r == ARCO_SEM_MEMORIA)
+            ok = false;
+        else if (verboso && r == ARCO_REORDENOU)
+            printf("(%d, %d): %d componentes reordenadas\n", u, v, o->tam_regiao);
+        else if (verboso && r == ARCO_FECHOU_CICLO) {
+            int x = componente_de(o, u), m = x;
+
+            printf("(%d, %d) fecha um ciclo: componente com %d vértices [", u, v, o->tam[x]);
+            do {
+                printf(" %d", m);
+                m = o->proximo_membro[m];
+            } while (m != x);
+            printf(" ] (região de %d componentes)\n", o->tam_regiao);
         }
     }
 
-    desalocar_grafo(g_transposto);
-    desalocar_lista(lista_ordenada);
+    if (ok)
+        printf("%lld arcos inseridos em %.3f s: %lld reordenações, %lld ciclos, %lld componentes visitadas; "
+               "%d componentes ao final\n", qtd_arcos, tempo_insercoes, o->qtd_reordenacoes, o->qtd_ciclos,
+               o->componentes_visitadas, o->qtd_componentes);
+    free(linha);
+    free(componente);
+    desalocar_ordem_dinamica(o);
+    return ok;
 }
 
-int main(void) {
+void exibir_uso(const char *programa) {
+    fprintf(stderr, "Uso: %s [-m modo] [-s fonte] [-T threads] [-q] < grafo\n", programa);
+    fprintf(stderr, "     %s -m topologica-dinamica -g grafo [-q] < arcos\n", programa);
+    fprintf(stderr, "  -m modo     bfs (padrão, passo a passo), dfs, bfs-vetor (BFS com fronteiras em\n");
+    fprintf(stderr, "              arranjos), bfs-direcional (alterna passos de cima para baixo e de baixo\n");
+    fprintf(stderr, "              para cima), bfs-paralela (níveis divididos entre as threads, com roubo\n");
+    fprintf(stderr, "              de trabalho) ou, em grafos dirigidos, topologica, cfc, cfc-paralela\n");
+    fprintf(stderr, "              (poda, busca para frente e para trás e coloração) ou topologica-dinamica\n");
+    fprintf(stderr, "              (mantém a ordem e as componentes enquanto lê arcos \"u v\" da entrada)\n");
+    fprintf(stderr, "  -s fonte    vértice de origem das buscas em largura (padrão 0)\n");
+    fprintf(stderr, "  -T threads  quantidade de threads dos modos bfs-paralela, cfc-paralela e topologica\n");
+    fprintf(stderr, "  -g grafo    lê o grafo do arquivo em vez da entrada (exigido por topologica-dinamica)\n");
+    fprintf(stderr, "  -q          exibe só o tempo, sem os passos nem o resultado vértice a vértice\n");
+    fprintf(stderr, "              (todos os modos menos o bfs)\n");
+}
 
-    int eh_grafo_direcionado, qtd_vertices, u, v;
+int main(int argc, char *argv[]) {
+    const char *modo = "bfs", *arquivo_grafo = NULL;
+    int s = 0, opcao;
+
+    while ((opcao = getopt(argc, argv, "m:s:T:qg:")) != -1) {
+        switch (opcao) {
+            case 'm':
+                modo = optarg;
+                break;
+            case 's':
+                s = atoi(optarg);
+                break;
+            case 'T':
+#ifdef _OPENMP
+                omp_set_num_threads(atoi(optarg));
+#endif
+                break;
+            case 'q':
+                verboso = false;
+                break;
+            case 'g':
+                arquivo_grafo = optarg;
+                break;
+            default:
+                exibir_uso(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
 
+    bool dinamica = strcmp(modo, "topologica-dinamica") == 0;
 
-    if (fscanf(stdin, "%d %d", &eh_grafo_direcionado, &qtd_vertices) == 2) {
-        // Criando o grafo
-        Grafo *g = criar_grafo(qtd_vertices);
+    if (dinamica && !arquivo_grafo) {
+        exibir_uso(argv[0]);
+        return EXIT_FAILURE;
+    }
 
-        if (g) {
-            // Inserindo as arestas do grafo
-            while (fscanf(stdin, "%d %d", &u, &v) == 2  
-                   &&  u < qtd_vertices
-                   &&  v < qtd_vertices)
-                    inserir_aresta(g, eh_grafo_direcionado, u, v);
+    int fd = STDIN_FILENO;
+    if (arquivo_grafo && (fd = open(arquivo_grafo, O_RDONLY)) < 0) {
+        perror(arquivo_grafo);
+        return EXIT_FAILURE;
+    }
 
+    // Lendo o grafo, em texto (.graph) ou no formato binário gerado pelo converter_grafo
+    Grafo *g = criar_grafo(carregar_grafo(fd, false));
 
-            // busca_em_largura(g, 0); // (G, s)
-            // busca_em_profundidade(g); // (G)
+    if (fd != STDIN_FILENO)
+        close(fd);  // o grafo binário continua mapeado depois de fechar o arquivo
 
-            
-            //if (eh_grafo_direcionado) {
-                //No *lista_ordenada = ordenacao_topologica(g);
-                //desalocar_lista(lista_ordenada);
-                //cfcs(g);
-            //} 
-            
+    if (!g)
+        return EXIT_FAILURE;
 
-            desalocar_grafo(g);
+    // Só as buscas em largura partem de uma fonte
+    if (strncmp(modo, "bfs", 3) == 0 && (s < 0 || s >= g->qtd_vertices)) {
+        fprintf(stderr, "Vértice fonte fora do intervalo [0, %d).\n", g->qtd_vertices);
+        desalocar_grafo(g);
+        return EXIT_FAILURE;
+    }
 
-            return EXIT_SUCCESS;
+    bool ok = true;
+
+    if (strcmp(modo, "bfs") == 0)
+        busca_em_largura(g, s); // (G, s)
+    else if (strcmp(modo, "dfs") == 0) {
+        double inicio = tempo_atual();
+        ok = busca_em_profundidade(g); // (G)
+        double fim = tempo_atual();
+
+        if (ok && !verboso)
+            printf("DFS com %d vértices: %.3f s\n", g->qtd_vertices, fim - inicio);
+    } else if (strcmp(modo, "topologica") == 0 || strcmp(modo, "cfc") == 0 || strcmp(modo, "cfc-paralela") == 0 || dinamica) {
+        if (!g->adj->eh_dirigido) {
+            fprintf(stderr, "O modo %s exige um grafo dirigido.\n", modo);
+            ok = false;
+        } else if (dinamica) {
+            ok = ordem_dinamica_da_entrada(g, stdin);
+            if (!ok)
+                fprintf(stderr, "Memória insuficiente.\n");
+        } else if (strcmp(modo, "cfc-paralela") == 0) {
+            int *componente = (int*) malloc(g->qtd_vertices * sizeof(int));
+            int qtd_threads = 1;
+#ifdef _OPENMP
+            qtd_threads = omp_get_max_threads();
+#endif
+            TemposCFC tempos;
+
+            arcos_de_entrada(g);  // o transposto é montado fora da medição, como a leitura do grafo
+
+            double inicio = tempo_atual();
+            int qtd_componentes = componente ? cfcs_paralela(g, componente, &tempos) : -1;
+            double fim = tempo_atual();
+
+            if (qtd_componentes < 0) {
+                fprintf(stderr, "Memória insuficiente.\n");
+                ok = false;
+            } else if (verboso)
+                exibir_cfcs(g->qtd_vertices, componente, qtd_componentes, false);
+            else {
+                printf("Componentes fortemente conexas em paralelo (%d thread%s) de %d vértices: %d componentes, %.3f s\n",
+                       qtd_threads, qtd_threads > 1 ? "s" : "", g->qtd_vertices, qtd_componentes, fim - inicio);
+                printf("  poda:               %.3f s (%d vértices)\n", tempos.poda, tempos.qtd_podados);
+                printf("  para frente e trás: %.3f s (componente do pivô com %d vértices)\n",
+                       tempos.frente_tras, tempos.tam_gigante);
+                printf("  coloração:          %.3f s (%d rodadas)\n", tempos.coloracao, tempos.rodadas_coloracao);
+            }
+            free(componente);
+        } else if (strcmp(modo, "cfc") == 0) {
+            int *componente = (int*) malloc(g->qtd_vertices * sizeof(int));
+            double inicio = tempo_atual();
+            int qtd_componentes = componente ? cfcs(g->adj, componente) : -1;
+            double fim = tempo_atual();
+
+            if (qtd_componentes < 0) {
+                fprintf(stderr, "Memória insuficiente.\n");
+                ok = false;
+            } else if (verboso)
+                exibir_cfcs(g->qtd_vertices, componente, qtd_componentes, true);
+            else
+                printf("Componentes fortemente conexas de %d vértices: %d componentes, %.3f s\n",
+                       g->qtd_vertices, qtd_componentes, fim - inicio);
+            free(componente);
+        } else {
+            int qtd_threads = 1;
+#ifdef _OPENMP
+            qtd_threads = omp_get_max_threads();
+#endif
+            double inicio = tempo_atual();
+            OrdemTopologica *o = ordenacao_topologica(g, qtd_threads > 1);
+            double fim = tempo_atual();
+
+            if (!o) {
+                fprintf(stderr, "Memória insuficiente.\n");
+                ok = false;
+            } else {
+                if (!verboso && o->tam_ciclo > 0)
+                    exibir_ciclo(o);
+                else if (!verboso)
+                    printf("Ordenação topológica com %d vértices (%d thread%s): %d níveis, %.3f s\n",
+                           g->qtd_vertices, qtd_threads, qtd_threads > 1 ? "s" : "", o->qtd_niveis, fim - inicio);
+                ok = o->tam_ciclo == 0;
+            }
+            desalocar_ordem_topologica(o);
         }
+    } else if (strcmp(modo, "bfs-vetor") == 0 || strcmp(modo, "bfs-direcional") == 0) {
+        bool direcional = strcmp(modo, "bfs-direcional") == 0;
+
+        if (direcional)
+            arcos_de_entrada(g);  // o transposto é montado fora da medição, como a leitura do grafo
+
+        double inicio = tempo_atual();
+        int alcancados = bfs_vetorial(g, s, direcional);
+        double fim = tempo_atual();
+
+        if (verboso)
+            exibir_resultado_bfs(g);
+        else
+            printf("BFS %s a partir de %d: %d vértices alcançados, %.3f s\n",
+                   direcional ? "com otimização de direção" : "com fronteiras em arranjos", s, alcancados, fim - inicio);
+    } else if (strcmp(modo, "bfs-paralela") == 0) {
+        int qtd_threads = 1;
+#ifdef _OPENMP
+        qtd_threads = omp_get_max_threads();
+#endif
+        double inicio = tempo_atual();
+        int alcancados = bfs_paralela(g, s);
+        double fim = tempo_atual();
+
+        if (verboso)
+            exibir_resultado_bfs(g);
+        else
+            printf("BFS paralela (%d thread%s) a partir de %d: %d vértices alcançados, %.3f s\n",
+                   qtd_threads, qtd_threads > 1 ? "s" : "", s, alcancados, fim - inicio);
+    } else {
+        exibir_uso(argv[0]);
+        ok = false;
     }
 
-    return EXIT_FAILURE;
-}
\ No newline at end of file
+    desalocar_grafo(g);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
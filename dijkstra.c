@@ -1,266 +1,141 @@
-#include <math.h>
 #include <stdio.h>
+#include <math.h>
 #include <float.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
 #include <stdbool.h>
 
-#define parent(i) ((i == 0) ? -1 : (int) floor((i - 1) / 2))
-#define left(i) (2 * i + 1) 
-#define right(i) (2 * i + 2)
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
+#include "grafo_csr.h"
+#include "leitura_grafo.h"
+#include "fila_prioridade.h"
+#include "cronometro.h"
+#include "hierarquia_contracao.h"
+
+// Com -q os passos do algoritmo não são exibidos (para medir o tempo em grafos grandes)
+static bool verboso = true;
 
-typedef struct FilaPrioridade FilaPrioridade;
 typedef struct Grafo Grafo;
 typedef struct Vertice Vertice;
-typedef struct No No;
 
 struct Grafo {
 	int qtd_vertices;
 	Vertice *vertices;
+	GrafoCSR *adj;  // arcos de u em adj->vizinhos/adj->pesos[adj->inicio[u] .. adj->inicio[u + 1] - 1]
+	GrafoCSR *adj_reversa;  // arcos invertidos, montados na primeira busca bidirecional
 };
 
 struct Vertice {
 	float d;
 	int pai;
-	No *lista_adjacencia;
-};
-
-struct No {
-	int vertice;
-	float peso;
-	No *proximo_no;
-};
-
-struct FilaPrioridade {
-    int m;             // tamanho da heap
-    int n;            // tamanho do arranjo
-    Vertice **arr;   // arranjo de vértices onde a fila será estruturada
-	int *pos;       // array para rastrear a posição de cada vértice na heap
 };
 
-FilaPrioridade *criar_fila_prioridade(int n) { // n é o tamanho do arranjo onde a fila será estruturada
-    FilaPrioridade *Q = (FilaPrioridade *) malloc(sizeof(FilaPrioridade));
-	// m0
-	if (Q) {
-		Q->arr = (Vertice **) malloc(n * sizeof(Vertice *));
-		Q->pos = (int *) malloc(n * sizeof(int));
-
-		if (Q->arr && Q->pos) {
-			Q->m = Q->n = n;
-
-			return Q;
-		}
-
-		if (Q->arr) 
-			free(Q->arr);
-
-        if (Q->pos) 
-			free(Q->pos);
-
-		free(Q);
-	}
-	return NULL;
-}
-
-void desalocar_fila_prioridade(FilaPrioridade *Q) {
-    if (Q) {
-		free(Q->arr); 
-		free(Q->pos);
-        free(Q);
-    }
-}
-
-void trocar_vertices(FilaPrioridade *Q, Grafo *g, int i, int j) {
-    // Faz a troca dos ponteiros dos vértices nas posições i e j da heap
-    Vertice *temp = Q->arr[i];
-    Q->arr[i] = Q->arr[j];
-    Q->arr[j] = temp;
-    
-    // Computa os índices dos vértices no array original do grafo
-    int vertex_i = Q->arr[i] - g->vertices;
-    int vertex_j = Q->arr[j] - g->vertices;
-    
-    // Atualiza o array de posições
-    Q->pos[vertex_i] = i;
-    Q->pos[vertex_j] = j;
-}
-
-void min_heapify(FilaPrioridade *Q, Grafo *g, int i) {
-    int l = left(i), r = right(i), menor = i;
-    
-    if (l < Q->m && Q->arr[l]->d < Q->arr[i]->d) 
-        menor = l;
-
-    if (r < Q->m && Q->arr[r]->d < Q->arr[menor]->d) 
-        menor = r;
-
-    if (menor != i) {
-        trocar_vertices(Q, g, i, menor);
-        min_heapify(Q, g, menor);
-    }    
-}
-
-Vertice *extrair_minimo(FilaPrioridade *Q, Grafo *g) {
-    if (Q->m <= 0) return NULL;
-    
-    Vertice *min = Q->arr[0];
-    Q->arr[0] = Q->arr[Q->m - 1];
-    
-    // Atualiza a posição do vértice que foi movido para a raiz
-    int vertex_idx = Q->arr[0] - g->vertices;
-    Q->pos[vertex_idx] = 0;
-    
-    Q->m--;
-    min_heapify(Q, g, 0);
-    return min;
-}
-
-// i: (in) chave | value: (in) novo valor para a chave i
-void diminuir_chave(FilaPrioridade *Q, Grafo *g, int alvo, float valor) {
-    int i = Q->pos[alvo];  // Obtém a posição atual na heap usando o índice do vértice no grafo
-    
-    if (valor < Q->arr[i]->d) {
-        Q->arr[i]->d = valor;
-        
-        while (i > 0 && Q->arr[parent(i)]->d > Q->arr[i]->d) {
-            trocar_vertices(Q, g, i, parent(i));
-            i = parent(i);
-        }
-    }
-}
+Grafo *criar_grafo(GrafoCSR *adj) {  // O grafo passa a ser dono de adj
+	if (!adj)
+		return NULL;
 
-Grafo *criar_grafo(int qtd_vertices) {
 	Grafo *g = (Grafo *) malloc(sizeof(Grafo));
 
 	if (g) {
-    	g->vertices = (Vertice *) malloc(qtd_vertices * sizeof(Vertice));
-
-    	if (g->vertices) {
-        	g->qtd_vertices = qtd_vertices;
+		g->vertices = (Vertice *) malloc(adj->qtd_vertices * sizeof(Vertice));
 
-        	for (int i = 0; i < g->qtd_vertices; i++)
-            	g->vertices[i].lista_adjacencia = NULL;
-       	 
-        	return g;
-    	}
-    	free(g);
+		if (g->vertices) {
+			g->qtd_vertices = adj->qtd_vertices;
+			g->adj = adj;
+			g->adj_reversa = NULL;
+			return g;
+		}
+		free(g);
 	}
+	desalocar_grafo_csr(adj);
 
 	return NULL;
 }
 
 void desalocar_grafo(Grafo *g) {
 	if (g) {
-    	if (g->vertices) {
-        	No *no_atual = NULL, *prox = NULL;
-       	 
-        	for (int i = 0; i < g->qtd_vertices; i++) {
-            	no_atual = g->vertices[i].lista_adjacencia;
-
-            	while (no_atual) {
-                	prox = no_atual->proximo_no;
-                	free(no_atual);
-                	no_atual = prox;
-            	}
-        	}
-        	free(g->vertices);
-    	}
-    	free(g);
-	}
-}
-
-No *criar_no_adjacente(int vertice, float peso) {  // "vertice" é a posição do vértice vizinho no array
-	No *novo_no = (No *) malloc(sizeof(No));
-
-	if (novo_no) {
-    	novo_no->vertice = vertice;
-    	novo_no->peso = peso;
-    	novo_no->proximo_no = NULL;
-    	return novo_no;
-	}
-	return NULL;
-}
-
-int aresta_existe(Grafo *g, int u, int v) {
-	No *no_atual = g->vertices[u].lista_adjacencia;
-    
-	// Percorre a lista adj. de u para verificar se v já está nela
-	while (no_atual) {
-    	if (no_atual->vertice == v)
-        	return 1; // (u,v) já existe   
-    	no_atual = no_atual->proximo_no;
-	}
-	return 0; // (u,v) não existe no grafo
-}
-
-void inserir_aresta(Grafo *g, int eh_grafo_dirigido, int u, int v, float peso) {
-	if (g && !aresta_existe(g, u, v)) {
-    	No *vizinho = criar_no_adjacente(v, peso);
-
-    	if (vizinho) {
-        	// Colocando v na lista adj. de u
-        	vizinho->proximo_no = g->vertices[u].lista_adjacencia;
-        	g->vertices[u].lista_adjacencia = vizinho;
-       	 
-        	// Coloca u na lista adj. de v quando o grafo for simples
-        	vizinho = criar_no_adjacente(u, peso);
-        	if (!eh_grafo_dirigido && vizinho) {
-            	vizinho->proximo_no = g->vertices[v].lista_adjacencia;
-            	g->vertices[v].lista_adjacencia = vizinho;
-        	}
-    	}
+		desalocar_grafo_csr(g->adj);
+		desalocar_grafo_csr(g->adj_reversa);
+		free(g->vertices);
+		free(g);
 	}
 }
 
 void inicializar_fonte_unica(Grafo *g, int s, FilaPrioridade *Q, bool *S) {
-	printf("O inicializar_fonte_unica está prestes a executar.\n");
+	if (verboso)
+		printf("O inicializar_fonte_unica está prestes a executar.\n");
 	for (int i = 0; i < g->qtd_vertices; i++) {
     	g->vertices[i].d = FLT_MAX;
     	g->vertices[i].pai = -1;
-		Q->arr[i] = &g->vertices[i];
-		Q->pos[i] = i;
 		S[i] = false;
-		printf("O vértice %d tem pai %d e estimativa inicial de %f.\n", i, g->vertices[i].pai, g->vertices[i].d);
+		if (verboso)
+			printf("O vértice %d tem pai %d e estimativa inicial de %f.\n", i, g->vertices[i].pai, g->vertices[i].d);
 	}
+	// Só a fonte entra na fila; os demais vértices entram quando a estimativa deles cai
 	g->vertices[s].d = 0;
-	diminuir_chave(Q, g, s, 0);
+	diminuir_chave(Q, s, 0);
 
-	printf("O vértice fonte s = %d teve sua estimativa atualizada para %f\n", s, g->vertices[s].d);
-	printf("inicializar_fonte_unica totalmente finalizado.\n\n");
+	if (verboso) {
+		printf("O vértice fonte s = %d teve sua estimativa atualizada para %f\n", s, g->vertices[s].d);
+		printf("inicializar_fonte_unica totalmente finalizado.\n\n");
+	}
 }
 
 void relaxar(Grafo *g, FilaPrioridade *Q, int u, int v, float peso) {
-	printf("Estimativa do vértice v = %d: %f.\n", v, g->vertices[v].d);
-	printf("Estimativa do vértive u = %d: %f.\n", u, g->vertices[u].d);
-	printf("w(%d,%d) = %f.\n", u, v, peso);
+	if (verboso) {
+		printf("Estimativa do vértice v = %d: %f.\n", v, g->vertices[v].d);
+		printf("Estimativa do vértive u = %d: %f.\n", u, g->vertices[u].d);
+		printf("w(%d,%d) = %f.\n", u, v, peso);
+	}
 
 	if (g->vertices[v].d > g->vertices[u].d + peso) {
-		printf("A aresta (%d,%d) com peso w(%d,%d) = %f irá relaxar, pois %f > %f + (%f).\n", 
-		u, v, u, v, peso, g->vertices[v].d, g->vertices[u].d, peso);
+		if (verboso)
+			printf("A aresta (%d,%d) com peso w(%d,%d) = %f irá relaxar, pois %f > %f + (%f).\n", 
+			u, v, u, v, peso, g->vertices[v].d, g->vertices[u].d, peso);
 
     	g->vertices[v].d = g->vertices[u].d + peso;
 		g->vertices[v].pai = u;
-		diminuir_chave(Q, g, v, g->vertices[v].d);
-	} else
+		diminuir_chave(Q, v, g->vertices[v].d);
+	} else if (verboso)
 		printf("A aresta (%d,%d) com peso w(%d,%d) = %f não sofreu relaxamento.\n",
 		u, v, u, v, peso);
 }
 
+void exibir_arestas(Grafo *g) {
+	for (int u = 0; u < g->qtd_vertices; u++) {
+		for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+			int v = g->adj->vizinhos[e];
+
+			if (g->adj->eh_dirigido || u <= v)  // cada aresta não dirigida aparece uma vez só
+				printf("Aresta (%d,%d) com peso w(%d,%d) = %f adicionada ao grafo.\n", u, v, u, v, g->adj->pesos[e]);
+		}
+	}
+	printf("\n");
+}
+
 void exibir_lista_adjacencia(Grafo *g) {
 	if (g) {
-    	No *no_atual = NULL;
-
-    	for (int i = 0; i < g->qtd_vertices; i++) {
-        	no_atual = g->vertices[i].lista_adjacencia;
-        	printf("\n[%d]", i);
+		for (int i = 0; i < g->qtd_vertices; i++) {
+			printf("\n[%d]", i);
 
-        	while (no_atual) {
-            	printf(" ~> [%d, %f]", no_atual->vertice, no_atual->peso);
-            	no_atual = no_atual->proximo_no;
-        	}
-    	}
-    	printf("\n\n");
+			for (int e = g->adj->inicio[i]; e < g->adj->inicio[i + 1]; e++)
+				printf(" ~> [%d, %f]", g->adj->vizinhos[e], g->adj->pesos[e]);
+		}
+		printf("\n\n");
 	}
 }
 
@@ -301,8 +176,9 @@ void desalocar_conjunto(bool *S) {
 		free(S);
 }
 
-void dijkstra(Grafo *g, int s) {
-	FilaPrioridade *Q = criar_fila_prioridade(g->qtd_vertices);
+// Com t >= 0 a busca para assim que t é extraído da fila (consulta ponto a ponto)
+void dijkstra(Grafo *g, int s, int t, TipoFila tipo_fila) {
+	FilaPrioridade *Q = criar_fila_prioridade(tipo_fila, g->qtd_vertices);
 	assert(Q != NULL);
 
 	bool *S = criar_conjunto(g->qtd_vertices);
@@ -310,78 +186,1342 @@ void dijkstra(Grafo *g, int s) {
 
 	inicializar_fonte_unica(g, s, Q, S);
 
-	//printf("Estado inicial da heap:\n");
-	//for (int i = 0; i < g->qtd_vertices; i++) {
-	//	printf("Q->arr[%d]->d = %f\n", i, Q->arr[i]->d);
-	//	printf("Q->arr[%d] = %p\n", i, Q->arr[i]);
-	//	printf("Q->arr[%d] - g->vertices = %ld\n", i, Q->arr[i] - g->vertices);
-	//}
+	if (verboso)
+    	printf("\nRodando o Dijkstra a partir do vértice fonte s = %d com a fila %s\n\n", s, nome_fila(tipo_fila));
 
-    printf("\nRodando o Dijkstra a partir do vértice fonte s = %d\n\n", s);
+	int u;
+	float d_u;
+    while ((u = extrair_minimo(Q, &d_u)) != -1) {
+		if (S[u])
+			continue;  // cópia obsoleta de um vértice já processado (filas radix e preguiçosa)
 
-    while (Q->m > 0) {
-		//printf("Estado da heap antes da extração:\n");
-		//for (int i = 0; i < g->qtd_vertices; i++) {
-			//printf("Q->arr[%d] - g->vertices = %ld\n", i, Q->arr[i] - g->vertices);
-			//printf("Q->arr[%d]->d = %f\n", i, Q->arr[i]->d);
-			//printf("Q->arr[%d] = %p\n", i, Q->arr[i]);
-		//}
-
-		min_heapify(Q, g, 0);
-        Vertice *u_vertice = extrair_minimo(Q, g);
-
-        int u = u_vertice - g->vertices;
         S[u] = true;
         
-        printf("Vértice %d extraído da fila. Estimativa d atual: %f\n", u, u_vertice->d);
-		printf("Vertice %d marcado como processado, ou seja, agora S[%d] = %d.\n", u, u, S[u]);
-
-        //printf("Estado da heap após a extração:\n");
-		//for (int i = 0; i < g->qtd_vertices; i++) {
-			//printf("Q->arr[%d] - g->vertices = %ld\n", i, Q->arr[i] - g->vertices);
-			//printf("Q->arr[%d]->d = %f\n", i, Q->arr[i]->d);
-			//printf("Q->arr[%d] = %p\n", i, Q->arr[i]);
-		//}
-
-        No *adj = g->vertices[u].lista_adjacencia;
-        while (adj) {
-            int v = adj->vertice;
-            if (!S[v]) { // v ainda não fi processado
-                printf("\nProcessando aresta (%d,%d):\n", u, v);
-                relaxar(g, Q, u, v, adj->peso);
-				diminuir_chave(Q, g, v, g->vertices[v].d);
+		if (verboso) {
+        	printf("Vértice %d extraído da fila. Estimativa d atual: %f\n", u, d_u);
+			printf("Vertice %d marcado como processado, ou seja, agora S[%d] = %d.\n", u, u, S[u]);
+		}
+
+		if (u == t)
+			break;  // d[t] já é definitiva
+
+        for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+            int v = g->adj->vizinhos[e];
+            if (!S[v]) { // v ainda não foi processado
+				if (verboso)
+                	printf("\nProcessando aresta (%d,%d):\n", u, v);
+                relaxar(g, Q, u, v, g->adj->pesos[e]);
             }
-            adj = adj->proximo_no;
         }
-        printf("\n");
+		if (verboso)
+        	printf("\n");
     }
 
 	desalocar_fila_prioridade(Q);
 	desalocar_conjunto(S);
 }
 
-int main(void) {
-	int eh_grafo_direcionado, qtd_vertices, u, v;
-	float peso = 0;
-    
-	if (fscanf(stdin, "%d %d", &eh_grafo_direcionado, &qtd_vertices) == 2) {
-    	Grafo *g = criar_grafo(qtd_vertices);
-   	 
-    	while (fscanf(stdin, "%d %d %f", &u, &v, &peso) != EOF) {
-        	inserir_aresta(g, eh_grafo_direcionado, u, v, peso);
-			printf("Aresta (%d,%d) com peso w(%d,%d) = %f adicionada ao grafo.\n", u, v, u, v, peso);
+/*
+ * Dijkstra bidirecional para uma consulta (s, t): uma busca parte de s no grafo e outra de t
+ * nos arcos invertidos, sempre avançando o lado com a menor última chave extraída. mi guarda
+ * o menor caminho s ~> t já visto ao relaxar um arco que liga as duas buscas; quando a soma
+ * das últimas chaves dos dois lados chega a mi, nenhum caminho melhor pode aparecer.
+ *
+ * Só o caminho s ~> t sai no formato de sempre (d[t] e a cadeia de pais de t até s); as
+ * estimativas dos demais vértices são as da busca a partir de s, possivelmente parciais.
+ */
+
+static int extrair_nao_processado(FilaPrioridade *Q, bool *S, float *chave) {
+	int u;
+
+	while ((u = extrair_minimo(Q, chave)) != -1 && S[u])
+		;  // descarta as cópias obsoletas
+	return u;
+}
+
+float dijkstra_bidirecional(Grafo *g, int s, int t, TipoFila tipo_fila) {
+	int n = g->qtd_vertices;
+
+	if (!g->adj_reversa) {
+		g->adj_reversa = transpor_grafo_csr(g->adj);
+		assert(g->adj_reversa != NULL);
+	}
+
+	FilaPrioridade *Q_ida = criar_fila_prioridade(tipo_fila, n), *Q_volta = criar_fila_prioridade(tipo_fila, n);
+	bool *S_ida = criar_conjunto(n), *S_volta = criar_conjunto(n);
+	float *d_volta = (float *) malloc((n > 0 ? n : 1) * sizeof(float));  // distância até t
+	int *sucessor = (int *) malloc((n > 0 ? n : 1) * sizeof(int));      // próximo vértice rumo a t
+	assert(Q_ida && Q_volta && S_ida && S_volta && d_volta && sucessor);
+
+	for (int i = 0; i < n; i++) {
+		g->vertices[i].d = d_volta[i] = FLT_MAX;
+		g->vertices[i].pai = sucessor[i] = -1;
+		S_ida[i] = S_volta[i] = false;
+	}
+	g->vertices[s].d = 0;
+	d_volta[t] = 0;
+	diminuir_chave(Q_ida, s, 0);
+	diminuir_chave(Q_volta, t, 0);
+
+	float mi = (s == t) ? 0 : FLT_MAX, topo_ida = 0, topo_volta = 0;
+	int ponte_u = -1, ponte_v = -1;  // arco (ponte_u, ponte_v) do melhor caminho visto
+
+	while (s != t) {
+		bool ida = topo_ida <= topo_volta;
+		float chave;
+		int u = extrair_nao_processado(ida ? Q_ida : Q_volta, ida ? S_ida : S_volta, &chave);
+
+		if (u == -1)
+			break;  // um dos lados esgotou tudo o que alcança: mi já é definitivo
+
+		if (ida) {
+			S_ida[u] = true;
+			topo_ida = chave;
+		} else {
+			S_volta[u] = true;
+			topo_volta = chave;
+		}
+
+		if (topo_ida + topo_volta >= mi)
+			break;
+
+		const GrafoCSR *arcos = ida ? g->adj : g->adj_reversa;
+
+		for (int e = arcos->inicio[u]; e < arcos->inicio[u + 1]; e++) {
+			int v = arcos->vizinhos[e];
+			float nova = chave + arcos->pesos[e];
+
+			if (ida) {
+				if (nova < g->vertices[v].d) {
+					g->vertices[v].d = nova;
+					g->vertices[v].pai = u;
+					diminuir_chave(Q_ida, v, nova);
+				}
+				if (d_volta[v] < FLT_MAX && nova + d_volta[v] < mi) {
+					mi = nova + d_volta[v];
+					ponte_u = u;
+					ponte_v = v;
+				}
+			} else {
+				if (nova < d_volta[v]) {
+					d_volta[v] = nova;
+					sucessor[v] = u;
+					diminuir_chave(Q_volta, v, nova);
+				}
+				if (g->vertices[v].d < FLT_MAX && nova + g->vertices[v].d < mi) {
+					mi = nova + g->vertices[v].d;
+					ponte_u = v;
+					ponte_v = u;
+				}
+			}
+		}
+	}
+
+	// Emenda a metade de trás: pai de cada vértice de ponte_v até t é o anterior no caminho
+	if (ponte_u != -1) {
+		g->vertices[ponte_v].pai = ponte_u;
+		for (int x = ponte_v; x != t; x = sucessor[x])
+			g->vertices[sucessor[x]].pai = x;
+		g->vertices[t].d = mi;
+	}
+
+	desalocar_fila_prioridade(Q_ida);
+	desalocar_fila_prioridade(Q_volta);
+	desalocar_conjunto(S_ida);
+	desalocar_conjunto(S_volta);
+	free(d_volta);
+	free(sucessor);
+
+	return mi;
+}
+
+/*
+ * Delta-stepping (Meyer e Sanders): os vértices ficam em baldes de largura delta pela
+ * estimativa d. O balde atual é esvaziado em rodadas que relaxam, em paralelo, as arestas
+ * leves (peso <= delta) dos vértices nele; quando ele fica vazio, as arestas pesadas dos
+ * vértices que passaram por ele são relaxadas de uma vez. O resultado fica nos mesmos
+ * campos d e pai usados pelo dijkstra().
+ *
+ * Um relaxamento a partir do balde atual b cai no máximo ceil(peso_max / delta) + 1 baldes
+ * adiante, então os baldes ficam num arranjo circular com essa quantidade de posições (até
+ * MAX_BALDES_DELTA): o balde b fica na posição b % qtd_baldes e do atual se passa direto ao
+ * próximo não vazio. Com um delta muito menor que os pesos, os pedidos que caem além da janela
+ * esperam numa heap pela estimativa e entram nela quando o balde atual se aproxima.
+ */
+
+#define MAX_BALDES_DELTA 1024
+
+typedef struct Balde {
+	int *vertices;
+	int tam, capacidade;
+} Balde;
+
+typedef struct Pedido {  // v teve a estimativa reduzida e deve entrar no balde b
+	int v;
+	long long b;
+} Pedido;
+
+typedef struct ListaPedidos {
+	Pedido *pedidos;
+	int tam, capacidade;
+} ListaPedidos;
+
+typedef struct BaldesDelta {
+	Balde *baldes;             // arranjo circular: o balde b fica em baldes[b % qtd]
+	int qtd;
+	long long atual;          // balde sendo esvaziado
+	FilaPrioridade *distantes; // vértices com balde >= atual + qtd, pela estimativa d
+} BaldesDelta;
+
+// (d, pai) de um vértice lidos e gravados juntos numa palavra de 64 bits
+typedef uint64_t __attribute__((may_alias)) PalavraVertice;
+
+static inline long long balde_de(float d, float delta) {
+	double b = d / delta;
+	return b < (double) (1LL << 62) ? (long long) b : 1LL << 62;
+}
+
+static void colocar_no_balde(Balde *balde, int v) {
+	if (balde->tam == balde->capacidade) {
+		balde->capacidade = balde->capacidade ? 2 * balde->capacidade : 16;
+		balde->vertices = (int *) realloc(balde->vertices, balde->capacidade * sizeof(int));
+		assert(balde->vertices != NULL);
+	}
+	balde->vertices[balde->tam++] = v;
+}
+
+static void adicionar_pedido(ListaPedidos *l, int v, long long b) {
+	if (l->tam == l->capacidade) {
+		l->capacidade = l->capacidade ? 2 * l->capacidade : 1024;
+		l->pedidos = (Pedido *) realloc(l->pedidos, l->capacidade * sizeof(Pedido));
+		assert(l->pedidos != NULL);
+	}
+	l->pedidos[l->tam].v = v;
+	l->pedidos[l->tam].b = b;
+	l->tam++;
+}
+
+// Relaxamento concorrente: troca (d, pai) de v por (nova_d, u) só se nova_d for menor
+static bool relaxar_atomico(Grafo *g, int u, int v, float nova_d) {
+	PalavraVertice *palavra = (PalavraVertice *) &g->vertices[v];
+	PalavraVertice antiga = __atomic_load_n(palavra, __ATOMIC_RELAXED);
+	Vertice novo = { nova_d, u };
+	PalavraVertice nova;
+
+	memcpy(&nova, &novo, sizeof(nova));
+
+	for (;;) {
+		Vertice atual;
+		memcpy(&atual, &antiga, sizeof(atual));
+
+		if (nova_d >= atual.d)
+			return false;
+		if (__atomic_compare_exchange_n(palavra, &antiga, nova, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			return true;
+	}
+}
+
+// Relaxa, em paralelo, as arestas leves (leves = true) ou pesadas dos vértices em fonte
+static void relaxar_em_paralelo(Grafo *g, const int *fonte, int qtd, float delta, bool leves,
+                                ListaPedidos *pedidos) {
+	#pragma omp parallel
+	{
+		int t = 0;
+#ifdef _OPENMP
+		t = omp_get_thread_num();
+#endif
+		ListaPedidos *local = &pedidos[t];
+
+		#pragma omp for schedule(dynamic, 64)
+		for (int i = 0; i < qtd; i++) {
+			int u = fonte[i];
+			float d_u;
+
+			__atomic_load(&g->vertices[u].d, &d_u, __ATOMIC_RELAXED);
+
+			for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+				float peso = g->adj->pesos[e];
+
+				if ((peso <= delta) == leves && relaxar_atomico(g, u, g->adj->vizinhos[e], d_u + peso))
+					adicionar_pedido(local, g->adj->vizinhos[e], balde_de(d_u + peso, delta));
+			}
+		}
+	}
+}
+
+/*
+ * Põe v no balde b, ou na heap dos distantes se b estiver além da janela. Um pedido para antes
+ * do balde atual (arredondamento de d / delta) vai para o atual, que ainda será revisitado.
+ */
+static void colocar_pedido(BaldesDelta *B, const Grafo *g, int v, long long b) {
+	if (b < B->atual)
+		b = B->atual;
+	if (b >= B->atual + B->qtd)
+		diminuir_chave(B->distantes, v, g->vertices[v].d);
+	else
+		colocar_no_balde(&B->baldes[b % B->qtd], v);
+}
+
+// Junta os pedidos de todas as threads nos baldes
+static void atender_pedidos(ListaPedidos *pedidos, int qtd_threads, BaldesDelta *B, const Grafo *g) {
+	for (int t = 0; t < qtd_threads; t++) {
+		for (int i = 0; i < pedidos[t].tam; i++)
+			colocar_pedido(B, g, pedidos[t].pedidos[i].v, pedidos[t].pedidos[i].b);
+		pedidos[t].tam = 0;
+	}
+}
+
+/*
+ * Tira da heap o distante de menor estimativa que ainda está pendente (d atual e arestas leves
+ * ainda não relaxadas com ela); as cópias obsoletas são descartadas. Retorna -1 se não houver.
+ */
+static int proximo_distante(BaldesDelta *B, const Grafo *g, const float *d_leves, float *d) {
+	int v;
+
+	while ((v = extrair_minimo(B->distantes, d)) != -1)
+		if (*d == g->vertices[v].d && *d < d_leves[v])
+			return v;
+	return -1;
+}
+
+/*
+ * Avança B->atual para o próximo balde com vértices, na janela ou entre os distantes, e traz
+ * para a janela os distantes que passam a caber nela. Retorna false se não sobrou nenhum.
+ */
+static bool avancar_balde(BaldesDelta *B, const Grafo *g, const float *d_leves, float delta) {
+	long long proximo = -1;
+
+	for (int j = 1; j < B->qtd; j++) {
+		if (B->baldes[(B->atual + j) % B->qtd].tam > 0) {
+			proximo = B->atual + j;
+			break;
 		}
-		printf("\n");
+	}
 
-		printf("Grafo de entrada:");
-		exibir_lista_adjacencia(g);
+	float d;
+	int v = proximo_distante(B, g, d_leves, &d);
 
-        dijkstra(g, 0);
+	if (v != -1 && (proximo == -1 || balde_de(d, delta) < proximo))
+		proximo = balde_de(d, delta);
+	if (proximo == -1)
+		return false;
 
-		exibir_resumo_grafo(g);
+	B->atual = proximo;
+	while (v != -1 && balde_de(d, delta) < B->atual + B->qtd) {
+		colocar_no_balde(&B->baldes[balde_de(d, delta) % B->qtd], v);
+		v = proximo_distante(B, g, d_leves, &d);
+	}
+	if (v != -1)
+		diminuir_chave(B->distantes, v, d);   // devolve o que ficou além da janela
+	return true;
+}
+
+void delta_stepping(Grafo *g, int s, float delta) {
+	int n = g->qtd_vertices, qtd_threads = 1;
+#ifdef _OPENMP
+	qtd_threads = omp_get_max_threads();
+#endif
+	float peso_max = 0;
+
+	#pragma omp parallel for reduction(max: peso_max)
+	for (int e = 0; e < g->adj->qtd_arcos; e++)
+		if (g->adj->pesos[e] > peso_max)
+			peso_max = g->adj->pesos[e];
+
+	double largura = ceil(peso_max / delta) + 2;
+	BaldesDelta B = { NULL, largura < MAX_BALDES_DELTA ? (int) largura : MAX_BALDES_DELTA, 0, NULL };
+
+	// d_leves e d_pesadas: estimativa com que as arestas leves e pesadas de cada vértice foram relaxadas
+	ListaPedidos *pedidos = (ListaPedidos *) calloc(qtd_threads, sizeof(ListaPedidos));
+	int *fronteira = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+	int *resolvidos = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+	float *d_leves = (float *) malloc((n > 0 ? n : 1) * sizeof(float));
+	float *d_pesadas = (float *) malloc((n > 0 ? n : 1) * sizeof(float));
+	bool *em_resolvidos = (bool *) calloc(n > 0 ? n : 1, sizeof(bool));
+	B.baldes = (Balde *) calloc(B.qtd, sizeof(Balde));
+	B.distantes = criar_fila_prioridade(FILA_BINARIA, n);
+	assert(pedidos && fronteira && resolvidos && d_leves && d_pesadas && em_resolvidos && B.baldes && B.distantes);
+
+	#pragma omp parallel for
+	for (int i = 0; i < n; i++) {
+		g->vertices[i].d = FLT_MAX;
+		g->vertices[i].pai = -1;
+		d_leves[i] = d_pesadas[i] = FLT_MAX;
+	}
+	g->vertices[s].d = 0;
+	colocar_no_balde(&B.baldes[0], s);
+
+	do {
+		Balde *balde = &B.baldes[B.atual % B.qtd];
+		int qtd_resolvidos = 0;
+
+		// Se um relaxamento de aresta pesada voltar ao balde atual, ele é esvaziado de novo
+		while (balde->tam > 0) {
+			while (balde->tam > 0) {
+				// Fronteira: vértices do balde cuja estimativa melhorou desde as últimas arestas leves
+				int qtd = 0;
+				for (int i = 0; i < balde->tam; i++) {
+					int v = balde->vertices[i];
+					float d = g->vertices[v].d;
+
+					if (d < d_leves[v] && balde_de(d, delta) <= B.atual) {
+						d_leves[v] = d;
+						fronteira[qtd++] = v;
+
+						if (!em_resolvidos[v]) {
+							em_resolvidos[v] = true;
+							resolvidos[qtd_resolvidos++] = v;
+						}
+					}
+				}
+				balde->tam = 0;
+
+				relaxar_em_paralelo(g, fronteira, qtd, delta, true, pedidos);
+				atender_pedidos(pedidos, qtd_threads, &B, g);
+			}
+
+			// As arestas pesadas levam a baldes posteriores: basta relaxá-las uma vez por estimativa
+			int qtd = 0;
+			for (int i = 0; i < qtd_resolvidos; i++) {
+				int v = resolvidos[i];
+
+				em_resolvidos[v] = false;
+				if (g->vertices[v].d < d_pesadas[v]) {
+					d_pesadas[v] = g->vertices[v].d;
+					fronteira[qtd++] = v;
+				}
+			}
+			qtd_resolvidos = 0;
+
+			relaxar_em_paralelo(g, fronteira, qtd, delta, false, pedidos);
+			atender_pedidos(pedidos, qtd_threads, &B, g);
+		}
+	} while (avancar_balde(&B, g, d_leves, delta));
+
+	for (int b = 0; b < B.qtd; b++)
+		free(B.baldes[b].vertices);
+	for (int t = 0; t < qtd_threads; t++)
+		free(pedidos[t].pedidos);
+	free(B.baldes);
+	desalocar_fila_prioridade(B.distantes);
+	free(pedidos);
+	free(fronteira);
+	free(resolvidos);
+	free(d_leves);
+	free(d_pesadas);
+	free(em_resolvidos);
+}
+
+// Largura padrão dos baldes: o peso médio dos arcos
+float delta_padrao(Grafo *g) {
+	double soma = 0;
+
+	for (int i = 0; i < g->adj->qtd_arcos; i++)
+		soma += g->adj->pesos[i];
+
+	return g->adj->qtd_arcos > 0 && soma > 0 ? (float) (soma / g->adj->qtd_arcos) : 1;
+}
+
+/*
+ * Modo servidor: o grafo é carregado uma vez e as consultas "fonte [alvo]" chegam, uma por
+ * linha, pela entrada padrão ou por um socket Unix. A fila, o conjunto S e a lista de
+ * vértices tocados são alocados uma vez só; entre uma consulta e outra só os vértices que
+ * a anterior tocou voltam a d = FLT_MAX e pai = -1, então uma consulta ponto a ponto custa
+ * o que ela explora, e não O(V).
+ *
+ * Com uma hierarquia de contração (-H, gerada pelo contrair_grafo), as consultas com alvo
+ * são respondidas por ela; a resposta volta para os mesmos campos d e pai do grafo.
+ */
+
+typedef struct EspacoConsulta {
+	FilaPrioridade *Q;
+	bool *S;
+	int *tocados;      // vértices com d < FLT_MAX na última consulta
+	int qtd_tocados;
+	int *caminho;     // caminho da resposta, da fonte ao alvo
+	float *dist;     // distância da fonte a cada vértice de caminho
+	ConsultaHierarquia *hierarquia;  // NULL sem -H
+} EspacoConsulta;
+
+void desalocar_espaco_consulta(EspacoConsulta *E);
+
+EspacoConsulta *criar_espaco_consulta(Grafo *g, TipoFila tipo_fila) {
+	int n = g->qtd_vertices > 0 ? g->qtd_vertices : 1;
+	EspacoConsulta *E = (EspacoConsulta *) calloc(1, sizeof(EspacoConsulta));
+
+	if (!E)
+		return NULL;
+
+	E->Q = criar_fila_prioridade(tipo_fila, g->qtd_vertices);
+	E->S = (bool *) calloc(n, sizeof(bool));
+	E->tocados = (int *) malloc(n * sizeof(int));
+	E->caminho = (int *) malloc(n * sizeof(int));
+	E->dist = (float *) malloc(n * sizeof(float));
+
+	if (!E->Q || !E->S || !E->tocados || !E->caminho || !E->dist) {
+		desalocar_espaco_consulta(E);
+		return NULL;
+	}
+
+	// Estado inicial de todas as consultas; daqui em diante só os tocados são restaurados
+	for (int i = 0; i < g->qtd_vertices; i++) {
+		g->vertices[i].d = FLT_MAX;
+		g->vertices[i].pai = -1;
+	}
+	return E;
+}
+
+void desalocar_espaco_consulta(EspacoConsulta *E) {
+	if (E) {
+		desalocar_fila_prioridade(E->Q);
+		free(E->S);
+		free(E->tocados);
+		free(E->caminho);
+		free(E->dist);
+		desalocar_consulta_hierarquia(E->hierarquia);
+		free(E);
+	}
+}
+
+static void restaurar_tocados(Grafo *g, EspacoConsulta *E) {
+	for (int i = 0; i < E->qtd_tocados; i++) {
+		int v = E->tocados[i];
+
+		g->vertices[v].d = FLT_MAX;
+		g->vertices[v].pai = -1;
+		E->S[v] = false;
+	}
+	E->qtd_tocados = 0;
+	esvaziar_fila(E->Q);
+}
+
+// Caminho s ~> t pela hierarquia, gravado nos campos d e pai dos vértices dele. Retorna o tamanho do caminho
+static int responder_pela_hierarquia(Grafo *g, EspacoConsulta *E, int s, int t) {
+	int tam = 0;
+
+	consultar_hierarquia(E->hierarquia, s, t, E->caminho, E->dist, &tam);
+
+	for (int i = 0; i < tam; i++) {
+		int v = E->caminho[i];
+
+		g->vertices[v].d = E->dist[i];
+		g->vertices[v].pai = i > 0 ? E->caminho[i - 1] : -1;
+		E->tocados[E->qtd_tocados++] = v;
+	}
+	return tam;
+}
+
+// Mesmo laço do dijkstra(), sem mensagens e sem inicialização O(V). Retorna quantos vértices foram processados
+int responder_consulta(Grafo *g, EspacoConsulta *E, int s, int t) {
+	int processados = 0;
+
+	restaurar_tocados(g, E);
+
+	if (E->hierarquia && t >= 0)
+		return responder_pela_hierarquia(g, E, s, t);
+
+	g->vertices[s].d = 0;
+	E->tocados[E->qtd_tocados++] = s;
+	diminuir_chave(E->Q, s, 0);
+
+	int u;
+	float d_u;
+	while ((u = extrair_minimo(E->Q, &d_u)) != -1) {
+		if (E->S[u])
+			continue;
+
+		E->S[u] = true;
+		processados++;
+		if (u == t)
+			break;
+
+		for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+			int v = g->adj->vizinhos[e];
+			float nova = d_u + g->adj->pesos[e];
+
+			if (!E->S[v] && nova < g->vertices[v].d) {
+				if (g->vertices[v].d == FLT_MAX)
+					E->tocados[E->qtd_tocados++] = v;
+				g->vertices[v].d = nova;
+				g->vertices[v].pai = u;
+				diminuir_chave(E->Q, v, nova);
+			}
+		}
+	}
+	return processados;
+}
+
+/*
+ * Responde às consultas de entrada em saida, uma linha por consulta:
+ *   "fonte alvo" -> "d v0 v1 ... alvo" (caminho da fonte ao alvo) ou "inf" se não há caminho
+ *   "fonte"      -> "alcançados N mais_distante v d"
+ * Linhas em branco são ignoradas e as inválidas recebem "erro ...". Retorna a quantidade de consultas.
+ */
+long atender_consultas(Grafo *g, EspacoConsulta *E, FILE *entrada, FILE *saida) {
+	char *linha = NULL;
+	size_t tam_linha = 0;
+	long qtd = 0;
+
+	while (getline(&linha, &tam_linha, entrada) != -1) {
+		int s, t, lidos = sscanf(linha, "%d %d", &s, &t);
+
+		if (lidos == EOF)
+			continue;  // linha em branco
+		if (lidos == 1)
+			t = -1;
+
+		if (lidos == 0)
+			fprintf(saida, "erro consulta inválida\n");
+		else if (s < 0 || s >= g->qtd_vertices || t >= g->qtd_vertices || (lidos == 2 && t < 0)) {
+			fprintf(saida, "erro vértice fora do intervalo [0, %d)\n", g->qtd_vertices);
+		} else if (t >= 0) {
+			responder_consulta(g, E, s, t);
+
+			if (g->vertices[t].d == FLT_MAX)
+				fprintf(saida, "inf\n");
+			else {
+				int tam = 0;
+				for (int v = t; v != -1; v = g->vertices[v].pai)
+					E->caminho[tam++] = v;
+
+				fprintf(saida, "%f", g->vertices[t].d);
+				while (tam > 0)
+					fprintf(saida, " %d", E->caminho[--tam]);
+				fprintf(saida, "\n");
+			}
+		} else {
+			int alcancados = responder_consulta(g, E, s, -1), mais_distante = s;
+
+			for (int i = 0; i < E->qtd_tocados; i++)
+				if (g->vertices[E->tocados[i]].d > g->vertices[mais_distante].d)
+					mais_distante = E->tocados[i];
+
+			fprintf(saida, "alcançados %d mais_distante %d %f\n", alcancados, mais_distante, g->vertices[mais_distante].d);
+		}
+		fflush(saida);  // quem consulta espera a resposta antes de mandar a próxima linha
+		qtd++;
+	}
+	free(linha);
+
+	return qtd;
+}
+
+// Aceita conexões em caminho, uma de cada vez, até o processo ser interrompido
+int servir_socket(Grafo *g, EspacoConsulta *E, const char *caminho) {
+	struct sockaddr_un endereco = { .sun_family = AF_UNIX };
+
+	if (strlen(caminho) >= sizeof(endereco.sun_path)) {
+		fprintf(stderr, "Caminho do socket longo demais: %s\n", caminho);
+		return 0;
+	}
+	strcpy(endereco.sun_path, caminho);
+
+	int servidor = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (servidor < 0) {
+		perror("socket");
+		return 0;
+	}
+
+	// Só um socket antigo (de uma execução anterior) é removido, nunca um arquivo comum
+	struct stat info;
+	if (lstat(caminho, &info) == 0) {
+		if (!S_ISSOCK(info.st_mode)) {
+			fprintf(stderr, "%s já existe e não é um socket.\n", caminho);
+			close(servidor);
+			return 0;
+		}
+		unlink(caminho);
+	}
+	if (bind(servidor, (struct sockaddr *) &endereco, sizeof(endereco)) < 0 || listen(servidor, 16) < 0) {
+		perror(caminho);
+		close(servidor);
+		return 0;
+	}
+	signal(SIGPIPE, SIG_IGN);  // cliente que fecha a conexão no meio de uma resposta não derruba o servidor
+
+	fprintf(stderr, "Atendendo consultas em %s\n", caminho);
+	for (;;) {
+		int conexao = accept(servidor, NULL, NULL);
+
+		if (conexao < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			break;
+		}
+
+		FILE *entrada = fdopen(conexao, "r"), *saida = NULL;
+		int copia = dup(conexao);
+
+		if (entrada && copia >= 0)
+			saida = fdopen(copia, "w");
+
+		if (saida) {
+			double inicio = tempo_atual();
+			long qtd = atender_consultas(g, E, entrada, saida);
+			double fim = tempo_atual();
+
+			fprintf(stderr, "%ld consultas em %.3f s (%.0f consultas/s)\n", qtd, fim - inicio, qtd / (fim - inicio));
+			fclose(saida);
+		} else if (copia >= 0)
+			close(copia);
+
+		if (entrada)
+			fclose(entrada);
+		else
+			close(conexao);
+	}
+
+	close(servidor);
+	unlink(caminho);
+	return 1;
+}
+
+/*
+ * Caminhos mínimos dinâmicos a partir de uma fonte fixa (-m dinamico): a árvore d/pai é
+ * mantida entre lotes de inserções, remoções e mudanças de peso de arcos, e cada lote só refaz
+ * a parte afetada, no estilo de Ramalingam e Reps:
+ *
+ *   1. Um arco da árvore (pai[v] = u) que ficou mais caro ou foi removido invalida a subárvore
+ *      de v: esses vértices voltam a d = infinito e cada um recebe, como estimativa, o melhor
+ *      arco vindo de um vértice fora da subárvore.
+ *   2. Um arco que ficou mais barato ou foi inserido entra na fila se melhora o destino.
+ *   3. Um Dijkstra a partir desses vértices propaga as mudanças e para quando nenhuma estimativa
+ *      melhora. Como os pesos não são negativos, cada vértice sai da fila uma vez por lote.
+ *
+ * Fora da subárvore invalidada as estimativas continuam sendo comprimentos de caminhos que
+ * existem, então o Dijkstra parcial termina com as distâncias exatas.
+ *
+ * O CSR não muda de forma: mudar o peso de um arco existente altera adj->pesos, remover usa o
+ * peso ARCO_REMOVIDO (infinito, nunca relaxa) e um arco novo vai para uma lista de arcos extras
+ * encadeada por vértice, nos dois sentidos.
+ */
+
+#define ARCO_REMOVIDO INFINITY
+
+typedef struct ArcoExtra {
+	int u, v;
+	float peso;
+	int prox_saida;    // próximo arco extra que sai de u, ou -1
+	int prox_entrada; // próximo arco extra que chega em v, ou -1
+} ArcoExtra;
+
+typedef struct MudancaArco {
+	int u, v;
+	float antigo, novo;
+} MudancaArco;
+
+typedef struct SSSPDinamico {
+	Grafo *g;
+	int s;
+	int *arco_direto;   // posição em g->adj de cada arco de g->adj_reversa (o peso fica só em g->adj)
+
+	ArcoExtra *extras;
+	int qtd_extras, capacidade_extras;
+	int *extra_saida, *extra_entrada;  // primeiro arco extra que sai de / chega em cada vértice, ou -1
+
+	MudancaArco *lote;
+	int qtd_lote, capacidade_lote;
+
+	FilaPrioridade *Q;
+	bool *afetado;
+	int *afetados;
+} SSSPDinamico;
+
+void desalocar_sssp_dinamico(SSSPDinamico *D);
+
+/*
+ * Troca g->adj por uma cópia em memória própria e calcula a árvore inicial. O grafo binário vem
+ * mapeado com MAP_PRIVATE, que até aceita escrita, mas os pesos alterados pelas atualizações não
+ * devem ficar sobre o mapeamento do arquivo: a cópia é a única dona deles.
+ */
+SSSPDinamico *criar_sssp_dinamico(Grafo *g, int s, TipoFila tipo_fila) {
+	int n = g->qtd_vertices > 0 ? g->qtd_vertices : 1;
+	SSSPDinamico *D = (SSSPDinamico *) calloc(1, sizeof(SSSPDinamico));
+	GrafoCSR *copia = copiar_grafo_csr(g->adj);
+
+	if (!D || !copia) {
+		free(D);
+		desalocar_grafo_csr(copia);
+		return NULL;
+	}
+	desalocar_grafo_csr(g->adj);
+	g->adj = copia;
+	if (!g->adj_reversa)
+		g->adj_reversa = transpor_grafo_csr(g->adj);
+
+	D->g = g;
+	D->s = s;
+	D->arco_direto = (int *) malloc((g->adj->qtd_arcos > 0 ? g->adj->qtd_arcos : 1) * sizeof(int));
+	D->extra_saida = (int *) malloc(n * sizeof(int));
+	D->extra_entrada = (int *) malloc(n * sizeof(int));
+	D->Q = criar_fila_prioridade(tipo_fila, g->qtd_vertices);
+	D->afetado = (bool *) calloc(n, sizeof(bool));
+	D->afetados = (int *) malloc(n * sizeof(int));
+	int *livre = (int *) malloc(n * sizeof(int));
+
+	if (!g->adj_reversa || !D->arco_direto || !D->extra_saida || !D->extra_entrada || !D->Q || !D->afetado ||
+	    !D->afetados || !livre) {
+		free(livre);
+		desalocar_sssp_dinamico(D);
+		return NULL;
+	}
+
+	// Mesma ordem de preenchimento do transpor_grafo_csr: origens em ordem crescente
+	memcpy(livre, g->adj_reversa->inicio, g->qtd_vertices * sizeof(int));
+	for (int u = 0; u < g->qtd_vertices; u++)
+		for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++)
+			D->arco_direto[livre[g->adj->vizinhos[e]]++] = e;
+	free(livre);
+
+	for (int v = 0; v < g->qtd_vertices; v++)
+		D->extra_saida[v] = D->extra_entrada[v] = -1;
+
+	dijkstra(g, s, -1, tipo_fila);
+	return D;
+}
+
+void desalocar_sssp_dinamico(SSSPDinamico *D) {
+	if (D) {
+		free(D->arco_direto);
+		free(D->extras);
+		free(D->extra_saida);
+		free(D->extra_entrada);
+		free(D->lote);
+		desalocar_fila_prioridade(D->Q);
+		free(D->afetado);
+		free(D->afetados);
+		free(D);
+	}
+}
+
+// Endereço do peso do arco (u, v), no CSR ou entre os extras, ou NULL se ele nunca existiu
+static float *peso_do_arco(SSSPDinamico *D, int u, int v) {
+	int e = posicao_arco_csr(D->g->adj, u, v);
+
+	if (e != -1)
+		return &D->g->adj->pesos[e];
+	for (int x = D->extra_saida[u]; x != -1; x = D->extras[x].prox_saida)
+		if (D->extras[x].v == v)
+			return &D->extras[x].peso;
+	return NULL;
+}
+
+/*
+ * Insere o arco (u, v) com o peso dado, muda o peso dele se já existir, ou o remove com
+ * peso = ARCO_REMOVIDO. A árvore só é corrigida no reparar_arvore(). Retorna false se faltar memória.
+ */
+bool mudar_arco(SSSPDinamico *D, int u, int v, float peso) {
+	float *atual = peso_do_arco(D, u, v);
+
+	if (!atual) {
+		if (peso == ARCO_REMOVIDO)
+			return true;   // remover um arco que não existe não muda nada
+
+		if (D->qtd_extras == D->capacidade_extras) {
+			int capacidade = D->capacidade_extras ? 2 * D->capacidade_extras : 1024;
+			ArcoExtra *novo = (ArcoExtra *) realloc(D->extras, capacidade * sizeof(ArcoExtra));
+
+			if (!novo)
+				return false;
+			D->extras = novo;
+			D->capacidade_extras = capacidade;
+		}
+
+		int x = D->qtd_extras++;
+		D->extras[x] = (ArcoExtra) { u, v, ARCO_REMOVIDO, D->extra_saida[u], D->extra_entrada[v] };
+		D->extra_saida[u] = D->extra_entrada[v] = x;
+		atual = &D->extras[x].peso;
+	}
+
+	if (D->qtd_lote == D->capacidade_lote) {
+		int capacidade = D->capacidade_lote ? 2 * D->capacidade_lote : 256;
+		MudancaArco *novo = (MudancaArco *) realloc(D->lote, capacidade * sizeof(MudancaArco));
+
+		if (!novo)
+			return false;
+		D->lote = novo;
+		D->capacidade_lote = capacidade;
+	}
+	D->lote[D->qtd_lote++] = (MudancaArco) { u, v, *atual, peso };
+	*atual = peso;
+	return true;
+}
+
+// v sai da fila com a estimativa d (ou entra, se ainda não estava)
+static inline void melhorar(SSSPDinamico *D, int v, float d, int pai) {
+	D->g->vertices[v].d = d;
+	D->g->vertices[v].pai = pai;
+	diminuir_chave(D->Q, v, d);
+}
+
+/*
+ * Aplica o lote de mudanças à árvore. Retorna quantos vértices foram invalidados (passo 1); em
+ * *processados, quantos saíram da fila no Dijkstra parcial.
+ */
+int reparar_arvore(SSSPDinamico *D, int *processados) {
+	Grafo *g = D->g;
+	const GrafoCSR *adj = g->adj, *entrada = g->adj_reversa;
+	Vertice *vert = g->vertices;
+	int qtd_afetados = 0;
+
+	esvaziar_fila(D->Q);   // a fila radix volta a aceitar qualquer chave
+
+	// 1. Raízes das subárvores invalidadas e, por uma busca pelos filhos na árvore, o resto delas
+	for (int i = 0; i < D->qtd_lote; i++) {
+		MudancaArco *m = &D->lote[i];
+
+		if (m->novo > m->antigo && vert[m->v].pai == m->u && !D->afetado[m->v]) {
+			D->afetado[m->v] = true;
+			D->afetados[qtd_afetados++] = m->v;
+		}
+	}
+	for (int i = 0; i < qtd_afetados; i++) {
+		int x = D->afetados[i];
+
+		for (int e = adj->inicio[x]; e < adj->inicio[x + 1]; e++) {
+			int z = adj->vizinhos[e];
+
+			if (vert[z].pai == x && !D->afetado[z]) {
+				D->afetado[z] = true;
+				D->afetados[qtd_afetados++] = z;
+			}
+		}
+		for (int a = D->extra_saida[x]; a != -1; a = D->extras[a].prox_saida) {
+			int z = D->extras[a].v;
+
+			if (vert[z].pai == x && !D->afetado[z]) {
+				D->afetado[z] = true;
+				D->afetados[qtd_afetados++] = z;
+			}
+		}
+	}
+	for (int i = 0; i < qtd_afetados; i++) {
+		vert[D->afetados[i]].d = FLT_MAX;
+		vert[D->afetados[i]].pai = -1;
+	}
+
+	// Estimativa de cada vértice invalidado pelos arcos que vêm de fora da subárvore
+	for (int i = 0; i < qtd_afetados; i++) {
+		int x = D->afetados[i], pai = -1;
+		float melhor = FLT_MAX;
+
+		for (int e = entrada->inicio[x]; e < entrada->inicio[x + 1]; e++) {
+			int y = entrada->vizinhos[e];
+			float d = vert[y].d + adj->pesos[D->arco_direto[e]];
+
+			if (!D->afetado[y] && vert[y].d != FLT_MAX && d < melhor) {
+				melhor = d;
+				pai = y;
+			}
+		}
+		for (int a = D->extra_entrada[x]; a != -1; a = D->extras[a].prox_entrada) {
+			int y = D->extras[a].u;
+			float d = vert[y].d + D->extras[a].peso;
+
+			if (!D->afetado[y] && vert[y].d != FLT_MAX && d < melhor) {
+				melhor = d;
+				pai = y;
+			}
+		}
+		if (pai != -1)
+			melhorar(D, x, melhor, pai);
+	}
+	for (int i = 0; i < qtd_afetados; i++)
+		D->afetado[D->afetados[i]] = false;
+
+	// 2. Arcos que ficaram mais baratos ou foram inseridos
+	for (int i = 0; i < D->qtd_lote; i++) {
+		MudancaArco *m = &D->lote[i];
+		float *peso = peso_do_arco(D, m->u, m->v);
+
+		if (vert[m->u].d != FLT_MAX && vert[m->u].d + *peso < vert[m->v].d)
+			melhorar(D, m->v, vert[m->u].d + *peso, m->u);
+	}
+	D->qtd_lote = 0;
+
+	// 3. Dijkstra parcial; uma cópia com chave maior que a estimativa atual é obsoleta (filas radix e preguiçosa)
+	int u;
+	float d_u;
+
+	*processados = 0;
+	while ((u = extrair_minimo(D->Q, &d_u)) != -1) {
+		if (d_u > vert[u].d)
+			continue;
+		(*processados)++;
+
+		for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++) {
+			int v = adj->vizinhos[e];
+			float nova = d_u + adj->pesos[e];
+
+			if (nova < vert[v].d)
+				melhorar(D, v, nova, u);
+		}
+		for (int a = D->extra_saida[u]; a != -1; a = D->extras[a].prox_saida) {
+			int v = D->extras[a].v;
+			float nova = d_u + D->extras[a].peso;
+
+			if (nova < vert[v].d)
+				melhorar(D, v, nova, u);
+		}
+	}
+	return qtd_afetados;
+}
+
+/*
+ * Lê lotes de mudanças da entrada, uma por linha, e responde em saida:
+ *   "+ u v peso"  insere o arco (u, v) ou muda o peso dele
+ *   "- u v"       remove o arco (u, v)
+ *   "? v"         distância e caminho até v, no formato das consultas do servidor
+ * Uma linha em branco (ou o fim da entrada) fecha o lote: a árvore é reparada e sai a linha
+ * "lote N: M mudanças, A vértices invalidados, P processados, T ms". Num grafo não dirigido
+ * cada mudança vale para os dois sentidos. Uma consulta no meio de um lote o fecha antes.
+ */
+void atender_atualizacoes(SSSPDinamico *D, FILE *entrada, FILE *saida) {
+	char *linha = NULL;
+	size_t tam_linha = 0;
+	int qtd_lotes = 0, qtd_mudancas = 0;
+	bool fim_da_entrada = false;
+
+	while (!fim_da_entrada) {
+		char comando = '\n';
+		int u, v, lidos = 0;
+		float peso = 0;
+
+		if (getline(&linha, &tam_linha, entrada) == -1)
+			fim_da_entrada = true;
+		else
+			lidos = sscanf(linha, " %c %d %d %f", &comando, &u, &v, &peso);
+
+		bool fecha_lote = fim_da_entrada || lidos <= 0 || comando == '?';
+
+		if (fecha_lote && qtd_mudancas > 0) {
+			int processados;
+			double inicio = tempo_atual();
+			int afetados = reparar_arvore(D, &processados);
+			double fim = tempo_atual();
+
+			fprintf(saida, "lote %d: %d mudanças, %d vértices invalidados, %d processados, %.3f ms\n",
+			        ++qtd_lotes, qtd_mudancas, afetados, processados, 1000 * (fim - inicio));
+			qtd_mudancas = 0;
+		}
+		if (fim_da_entrada || lidos <= 0) {
+			fflush(saida);
+			continue;
+		}
+
+		int n = D->g->qtd_vertices;
+		bool ok = true;
+
+		if (comando == '?' && lidos >= 2 && u >= 0 && u < n) {
+			Vertice *vert = D->g->vertices;
+
+			if (vert[u].d == FLT_MAX)
+				fprintf(saida, "inf\n");
+			else {
+				int tam = 0, *caminho = D->afetados;   // fora do reparo, afetados serve de rascunho
+
+				for (int x = u; x != -1 && tam < n; x = vert[x].pai)
+					caminho[tam++] = x;
+				fprintf(saida, "%f", vert[u].d);
+				while (tam > 0)
+					fprintf(saida, " %d", caminho[--tam]);
+				fprintf(saida, "\n");
+			}
+		} else if ((comando == '+' && lidos == 4 && peso >= 0) || (comando == '-' && lidos >= 3)) {
+			if (u < 0 || u >= n || v < 0 || v >= n)
+				fprintf(saida, "erro vértice fora do intervalo [0, %d)\n", n);
+			else {
+				float novo = comando == '+' ? peso : ARCO_REMOVIDO;
+
+				ok = mudar_arco(D, u, v, novo) && (D->g->adj->eh_dirigido || mudar_arco(D, v, u, novo));
+				qtd_mudancas++;
+			}
+		} else
+			fprintf(saida, "erro linha inválida (use \"+ u v peso\" com peso >= 0, \"- u v\" ou \"? v\")\n");
+
+		if (!ok) {
+			fprintf(saida, "erro memória insuficiente\n");
+			break;
+		}
+	}
+	fflush(saida);
+	free(linha);
+}
+
+typedef enum Modo { MODO_DIJKSTRA, MODO_DELTA, MODO_BIDIRECIONAL, MODO_HIERARQUIA, MODO_DINAMICO } Modo;
+
+// Carrega a hierarquia de caminho e a prende ao espaço de consultas. Retorna false em caso de erro
+bool usar_hierarquia(Grafo *g, EspacoConsulta *E, const char *caminho, HierarquiaContracao **H) {
+	int fd = open(caminho, O_RDONLY);
+
+	if (fd < 0) {
+		perror(caminho);
+		return false;
+	}
+	*H = carregar_hierarquia(fd);
+	close(fd);
+
+	if (!*H) {
+		fprintf(stderr, "%s não é uma hierarquia de contração válida.\n", caminho);
+		return false;
+	}
+	if ((*H)->qtd_vertices != g->qtd_vertices) {
+		fprintf(stderr, "A hierarquia %s tem %d vértices e o grafo, %d.\n", caminho, (*H)->qtd_vertices, g->qtd_vertices);
+		return false;
+	}
+	if ((*H)->qtd_arcos_grafo != g->adj->qtd_arcos || (*H)->soma_grafo != soma_verificacao_csr(g->adj)) {
+		fprintf(stderr, "A hierarquia %s foi construída a partir de outro grafo.\n", caminho);
+		return false;
+	}
+
+	E->hierarquia = criar_consulta_hierarquia(*H);
+	return E->hierarquia != NULL;
+}
+
+void exibir_uso(const char *programa) {
+	fprintf(stderr, "Uso: %s [-m modo] [-f fila] [-D delta] [-T threads] [-s fonte] [-t alvo] [-q] < grafo\n", programa);
+	fprintf(stderr, "     %s -c -g grafo [-f fila] < consultas\n", programa);
+	fprintf(stderr, "     %s -u socket [-g grafo] [-f fila]\n", programa);
+	fprintf(stderr, "     %s -H hierarquia -s fonte -t alvo [-q] < grafo\n", programa);
+	fprintf(stderr, "     %s -m dinamico -g grafo [-s fonte] [-f fila] < atualizações\n", programa);
+	fprintf(stderr, "  -m modo     dijkstra (padrão), delta (delta-stepping paralelo)\n");
+	fprintf(stderr, "              bidirecional (consulta s -> t, exige -t) ou dinamico (mantém a árvore\n");
+	fprintf(stderr, "              de s sob lotes \"+ u v peso\" / \"- u v\" / \"? v\" da entrada, exige -g)\n");
+	fprintf(stderr, "  -f fila     binaria (padrão), 4aria, radix ou preguicosa\n");
+	fprintf(stderr, "  -D delta    largura dos baldes do delta-stepping (padrão: peso médio dos arcos)\n");
+	fprintf(stderr, "  -T threads  quantidade de threads do delta-stepping\n");
+	fprintf(stderr, "  -s fonte    vértice de origem (padrão 0)\n");
+	fprintf(stderr, "  -t alvo     para a busca assim que o caminho mínimo até o alvo é conhecido\n");
+	fprintf(stderr, "  -q          não exibe os passos nem a tabela final, só o tempo\n");
+	fprintf(stderr, "  -g grafo    lê o grafo do arquivo em vez da entrada padrão\n");
+	fprintf(stderr, "  -c          servidor: responde às consultas \"fonte [alvo]\" da entrada padrão (exige -g)\n");
+	fprintf(stderr, "  -u socket   servidor: responde às consultas das conexões no socket Unix\n");
+	fprintf(stderr, "  -H arquivo  responde às consultas com alvo pela hierarquia de contração do contrair_grafo\n");
+}
+
+int main(int argc, char *argv[]) {
+	TipoFila tipo_fila = FILA_BINARIA;
+	Modo modo = MODO_DIJKSTRA;
+	float delta = 0;
+	int s = 0, t = -1, opcao;
+	bool consultas_na_entrada = false;
+	const char *arquivo_grafo = NULL, *caminho_socket = NULL, *arquivo_hierarquia = NULL;
+
+	while ((opcao = getopt(argc, argv, "m:f:D:T:s:t:qg:cu:H:")) != -1) {
+		switch (opcao) {
+			case 'm':
+				if (strcmp(optarg, "dijkstra") == 0)
+					modo = MODO_DIJKSTRA;
+				else if (strcmp(optarg, "delta") == 0)
+					modo = MODO_DELTA;
+				else if (strcmp(optarg, "bidirecional") == 0)
+					modo = MODO_BIDIRECIONAL;
+				else if (strcmp(optarg, "dinamico") == 0)
+					modo = MODO_DINAMICO;
+				else {
+					exibir_uso(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'f':
+				if (!fila_por_nome(optarg, &tipo_fila)) {
+					exibir_uso(argv[0]);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'D':
+				delta = atof(optarg);
+				break;
+			case 'T':
+#ifdef _OPENMP
+				omp_set_num_threads(atoi(optarg));
+#endif
+				break;
+			case 's':
+				s = atoi(optarg);
+				break;
+			case 't':
+				t = atoi(optarg);
+				break;
+			case 'q':
+				verboso = false;
+				break;
+			case 'g':
+				arquivo_grafo = optarg;
+				break;
+			case 'c':
+				consultas_na_entrada = true;
+				break;
+			case 'u':
+				caminho_socket = optarg;
+				break;
+			case 'H':
+				arquivo_hierarquia = optarg;
+				modo = MODO_HIERARQUIA;
+				break;
+			default:
+				exibir_uso(argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	bool servidor = consultas_na_entrada || caminho_socket;
+
+	if (((modo == MODO_BIDIRECIONAL || modo == MODO_HIERARQUIA) && t < 0 && !servidor) || (consultas_na_entrada && (!arquivo_grafo || caminho_socket)) ||
+	    (modo == MODO_DINAMICO && (!arquivo_grafo || servidor))) {
+		exibir_uso(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int fd = STDIN_FILENO;
+	if (arquivo_grafo && (fd = open(arquivo_grafo, O_RDONLY)) < 0) {
+		perror(arquivo_grafo);
+		return EXIT_FAILURE;
+	}
+
+	// Entrada em texto (.graph) ou no formato binário gerado pelo converter_grafo
+	Grafo *g = criar_grafo(carregar_grafo(fd, true));
+
+	if (fd != STDIN_FILENO)
+		close(fd);  // o grafo binário continua mapeado depois de fechar o arquivo
+
+	if (g && modo == MODO_DINAMICO) {
+		if (s < 0 || s >= g->qtd_vertices || possui_peso_negativo(g->adj)) {
+			fprintf(stderr, "O modo dinâmico exige uma fonte em [0, %d) e pesos não negativos.\n", g->qtd_vertices);
+			desalocar_grafo(g);
+			return EXIT_FAILURE;
+		}
+
+		verboso = false;
+		double inicio = tempo_atual();
+		SSSPDinamico *D = criar_sssp_dinamico(g, s, tipo_fila);
+		double fim = tempo_atual();
+
+		bool ok = D != NULL;
+
+		if (ok) {
+			fprintf(stderr, "Árvore inicial a partir de %d: %.3f s\n", s, fim - inicio);
+			atender_atualizacoes(D, stdin, stdout);
+		} else
+			fprintf(stderr, "Memória insuficiente.\n");
+
+		desalocar_sssp_dinamico(D);
+		desalocar_grafo(g);
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (g && servidor) {
+		if (possui_peso_negativo(g->adj)) {
+			fprintf(stderr, "O Dijkstra exige pesos não negativos.\n");
+			desalocar_grafo(g);
+			return EXIT_FAILURE;
+		}
+
+		EspacoConsulta *E = criar_espaco_consulta(g, tipo_fila);
+		assert(E != NULL);
+
+		HierarquiaContracao *H = NULL;
+		int ok = 1;
+		if (arquivo_hierarquia && !usar_hierarquia(g, E, arquivo_hierarquia, &H))
+			ok = 0;
+		else if (caminho_socket)
+			ok = servir_socket(g, E, caminho_socket);
+		else {
+			double inicio = tempo_atual();
+			long qtd = atender_consultas(g, E, stdin, stdout);
+			double fim = tempo_atual();
+
+			fprintf(stderr, "%ld consultas em %.3f s (%.0f consultas/s)\n", qtd, fim - inicio, qtd / (fim - inicio));
+		}
+
+		desalocar_espaco_consulta(E);
+		desalocar_hierarquia(H);
+		desalocar_grafo(g);
+
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (g) {
+		bool exige_pesos_positivos = modo != MODO_DIJKSTRA || tipo_fila == FILA_RADIX;
+
+		if (s < 0 || s >= g->qtd_vertices || t >= g->qtd_vertices) {
+			fprintf(stderr, "Vértice fonte ou alvo fora do intervalo [0, %d).\n", g->qtd_vertices);
+			desalocar_grafo(g);
+			return EXIT_FAILURE;
+		}
+		if (exige_pesos_positivos && possui_peso_negativo(g->adj)) {
+			fprintf(stderr, "A fila radix, o delta-stepping, a busca bidirecional e a hierarquia de contração exigem pesos não negativos.\n");
+			desalocar_grafo(g);
+			return EXIT_FAILURE;
+		}
+
+		if (verboso) {
+			exibir_arestas(g);
+			printf("Grafo de entrada:");
+			exibir_lista_adjacencia(g);
+		}
+
+		if (modo == MODO_DELTA && delta <= 0)
+			delta = delta_padrao(g);
+
+		// A hierarquia é carregada fora da medição, assim como o grafo
+		HierarquiaContracao *H = NULL;
+		EspacoConsulta *E = NULL;
+		if (modo == MODO_HIERARQUIA) {
+			E = criar_espaco_consulta(g, tipo_fila);
+			assert(E != NULL);
+
+			if (!usar_hierarquia(g, E, arquivo_hierarquia, &H)) {
+				desalocar_espaco_consulta(E);
+				desalocar_hierarquia(H);
+				desalocar_grafo(g);
+				return EXIT_FAILURE;
+			}
+		}
+
+		double inicio = tempo_atual();
+		if (modo == MODO_HIERARQUIA)
+			responder_consulta(g, E, s, t);
+		else if (modo == MODO_DELTA)
+			delta_stepping(g, s, delta);
+		else if (modo == MODO_BIDIRECIONAL)
+			dijkstra_bidirecional(g, s, t, tipo_fila);
+		else
+        	dijkstra(g, s, t, tipo_fila);
+		double fim = tempo_atual();
+
+		if (t >= 0 && modo != MODO_DELTA) {
+			// Consulta ponto a ponto: só o caminho até o alvo interessa
+			if (g->vertices[t].d == FLT_MAX)
+				printf("Não existe caminho de %d a %d.\n", s, t);
+			else {
+				printf("Caminho mínimo de %d a %d (d = %f): ", s, t, g->vertices[t].d);
+				exibir_caminho_minimo(g, t);
+				printf("\n");
+			}
+		} else if (verboso)
+			exibir_resumo_grafo(g);
+
+		if (!verboso) {
+			int qtd_threads = 1;
+#ifdef _OPENMP
+			qtd_threads = omp_get_max_threads();
+#endif
+			if (modo == MODO_DELTA)
+				printf("Delta-stepping (delta = %g, %d threads) a partir de %d: %.3f s\n", delta, qtd_threads, s, fim - inicio);
+			else if (modo == MODO_HIERARQUIA)
+				printf("Hierarquia de contração de %d a %d: %.3f ms\n", s, t, 1000 * (fim - inicio));
+			else
+				printf("%s (fila %s) a partir de %d: %.3f s\n", modo == MODO_BIDIRECIONAL ? "Dijkstra bidirecional" : "Dijkstra",
+				       nome_fila(tipo_fila), s, fim - inicio);
+		}
+
+		desalocar_espaco_consulta(E);
+		desalocar_hierarquia(H);
     	desalocar_grafo(g);
    	 
     	return EXIT_SUCCESS;
 	}
 	return EXIT_FAILURE;
-}
\ No newline at end of file
+}
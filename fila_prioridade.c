@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fila_prioridade.h"
+
+#define CAPACIDADE_MINIMA 1024
+
+// Ordem dos itens nas heaps: pela chave e, em caso de empate, pelo índice do vértice
+static inline bool precede(ItemFila a, ItemFila b) {
+    return a.chave < b.chave || (a.chave == b.chave && a.vertice < b.vertice);
+}
+
+static inline void colocar(FilaPrioridade *Q, int i, ItemFila x) {
+    Q->itens[i] = x;
+    if (Q->pos)
+        Q->pos[x.vertice] = i;
+}
+
+static void garantir_capacidade(FilaPrioridade *Q) {
+    if (Q->m == Q->capacidade) {
+        ItemFila *novo = (ItemFila *) realloc(Q->itens, 2 * (size_t) Q->capacidade * sizeof(ItemFila));
+        assert(novo != NULL);
+
+        Q->itens = novo;
+        Q->capacidade *= 2;
+    }
+}
+
+/*
+ * Heap d-ária iterativa. As funções recebem a aridade como constante para que o compilador
+ * gere uma versão especializada (divisão por 2 ou por 4 viram deslocamentos).
+ */
+static inline void subir(FilaPrioridade *Q, int i, ItemFila x, int d) {
+    while (i > 0) {
+        int pai = (i - 1) / d;
+
+        if (!precede(x, Q->itens[pai]))
+            break;
+
+        colocar(Q, i, Q->itens[pai]);
+        i = pai;
+    }
+    colocar(Q, i, x);
+}
+
+static inline void descer(FilaPrioridade *Q, int i, ItemFila x, int d) {
+    for (;;) {
+        int primeiro = d * i + 1;
+
+        if (primeiro >= Q->m)
+            break;
+
+        int ultimo = primeiro + d < Q->m ? primeiro + d : Q->m, menor = primeiro;
+        for (int c = primeiro + 1; c < ultimo; c++)
+            if (precede(Q->itens[c], Q->itens[menor]))
+                menor = c;
+
+        if (!precede(Q->itens[menor], x))
+            break;
+
+        colocar(Q, i, Q->itens[menor]);
+        i = menor;
+    }
+    colocar(Q, i, x);
+}
+
+static inline int extrair_heap(FilaPrioridade *Q, float *chave, int d) {
+    if (Q->m == 0)
+        return -1;
+
+    ItemFila minimo = Q->itens[0];
+
+    if (Q->pos)
+        Q->pos[minimo.vertice] = -1;
+
+    Q->m--;
+    if (Q->m > 0)
+        descer(Q, 0, Q->itens[Q->m], d);
+
+    if (chave)
+        *chave = minimo.chave;
+    return minimo.vertice;
+}
+
+static inline void diminuir_heap(FilaPrioridade *Q, int v, float chave, int d) {
+    ItemFila x = { chave, v };
+    int i = Q->pos[v];
+
+    if (i < 0)
+        i = Q->m++;          // v ainda não está na fila: entra no fim e sobe
+    else if (!precede(x, Q->itens[i]))
+        return;            // a chave nova não é menor
+
+    subir(Q, i, x, d);
+}
+
+static void diminuir_binaria(FilaPrioridade *Q, int v, float chave) { diminuir_heap(Q, v, chave, 2); }
+static int extrair_binaria(FilaPrioridade *Q, float *chave) { return extrair_heap(Q, chave, 2); }
+
+static void diminuir_4aria(FilaPrioridade *Q, int v, float chave) { diminuir_heap(Q, v, chave, 4); }
+static int extrair_4aria(FilaPrioridade *Q, float *chave) { return extrair_heap(Q, chave, 4); }
+
+// Sem diminuir_chave: a melhora entra como um item novo e a cópia antiga sai depois, obsoleta
+static void diminuir_preguicosa(FilaPrioridade *Q, int v, float chave) {
+    ItemFila x = { chave, v };
+
+    garantir_capacidade(Q);
+    subir(Q, Q->m++, x, 4);
+}
+
+// Chaves reais não negativas têm a mesma ordem que os seus bits lidos como inteiros sem sinal
+static inline uint32_t bits_da_chave(float chave) {
+    uint32_t bits;
+
+    if (chave == 0)
+        chave = 0;  // -0.0 e 0.0 viram a mesma chave
+    memcpy(&bits, &chave, sizeof(bits));
+    return bits;
+}
+
+static inline int balde_de(uint32_t bits, uint32_t ultima) {
+    return bits == ultima ? 0 : 32 - __builtin_clz(bits ^ ultima);
+}
+
+static void colocar_no_balde(FilaPrioridade *Q, int b, ItemFila x) {
+    if (Q->tam_balde[b] == Q->cap_balde[b]) {
+        int nova = Q->cap_balde[b] ? 2 * Q->cap_balde[b] : 64;
+        ItemFila *novo = (ItemFila *) realloc(Q->baldes[b], nova * sizeof(ItemFila));
+        assert(novo != NULL);
+
+        Q->baldes[b] = novo;
+        Q->cap_balde[b] = nova;
+    }
+    Q->baldes[b][Q->tam_balde[b]++] = x;
+}
+
+static void diminuir_radix(FilaPrioridade *Q, int v, float chave) {
+    ItemFila x = { chave, v };
+    uint32_t bits = bits_da_chave(chave);
+
+    assert(bits >= Q->ultima && bits < 0x80000000u);  // fila monótona e chaves não negativas
+
+    colocar_no_balde(Q, balde_de(bits, Q->ultima), x);
+    Q->m++;
+}
+
+static int extrair_radix(FilaPrioridade *Q, float *chave) {
+    if (Q->m == 0)
+        return -1;
+
+    if (Q->tam_balde[0] == 0) {
+        // O menor item do primeiro balde não vazio passa a ser a referência e o balde é redistribuído
+        int b = 1;
+        while (Q->tam_balde[b] == 0)
+            b++;
+
+        uint32_t menor = UINT32_MAX;
+        for (int i = 0; i < Q->tam_balde[b]; i++) {
+            uint32_t bits = bits_da_chave(Q->baldes[b][i].chave);
+            if (bits < menor)
+                menor = bits;
+        }
+        Q->ultima = menor;
+
+        // Todo item do balde b cai num balde de índice menor que b
+        for (int i = 0; i < Q->tam_balde[b]; i++)
+            colocar_no_balde(Q, balde_de(bits_da_chave(Q->baldes[b][i].chave), menor), Q->baldes[b][i]);
+        Q->tam_balde[b] = 0;
+    }
+
+    ItemFila x = Q->baldes[0][--Q->tam_balde[0]];
+    Q->m--;
+
+    if (chave)
+        *chave = x.chave;
+    return x.vertice;
+}
+
+static const OperacoesFila operacoes[QTD_TIPOS_FILA] = {
+    [FILA_BINARIA]    = { "binaria",    diminuir_binaria,    extrair_binaria },
+    [FILA_4ARIA]      = { "4aria",      diminuir_4aria,      extrair_4aria },
+    [FILA_RADIX]      = { "radix",      diminuir_radix,      extrair_radix },
+    [FILA_PREGUICOSA] = { "preguicosa", diminuir_preguicosa, extrair_4aria },
+};
+
+FilaPrioridade *criar_fila_prioridade(TipoFila tipo, int qtd_vertices) {
+    FilaPrioridade *Q = (FilaPrioridade *) calloc(1, sizeof(FilaPrioridade));
+
+    if (!Q)
+        return NULL;
+
+    Q->tipo = tipo;
+    Q->op = &operacoes[tipo];
+    Q->qtd_vertices = qtd_vertices;
+
+    if (tipo == FILA_RADIX)
+        return Q;
+
+    // Com diminuir_chave cada vértice aparece no máximo uma vez; a fila preguiçosa cresce sob demanda
+    Q->capacidade = qtd_vertices > CAPACIDADE_MINIMA ? qtd_vertices : CAPACIDADE_MINIMA;
+    Q->itens = (ItemFila *) malloc(Q->capacidade * sizeof(ItemFila));
+
+    if (Q->itens && tipo != FILA_PREGUICOSA) {
+        Q->pos = (int *) malloc((qtd_vertices > 0 ? qtd_vertices : 1) * sizeof(int));
+
+        if (Q->pos)
+            for (int i = 0; i < qtd_vertices; i++)
+                Q->pos[i] = -1;
+    }
+
+    if (!Q->itens || (tipo != FILA_PREGUICOSA && !Q->pos)) {
+        desalocar_fila_prioridade(Q);
+        return NULL;
+    }
+    return Q;
+}
+
+void desalocar_fila_prioridade(FilaPrioridade *Q) {
+    if (Q) {
+        free(Q->itens);
+        free(Q->pos);
+        for (int b = 0; b < QTD_BALDES_RADIX; b++)
+            free(Q->baldes[b]);
+        free(Q);
+    }
+}
+
+void esvaziar_fila(FilaPrioridade *Q) {
+    if (Q->pos)
+        for (int i = 0; i < Q->m; i++)
+            Q->pos[Q->itens[i].vertice] = -1;
+
+    for (int b = 0; b < QTD_BALDES_RADIX; b++)
+        Q->tam_balde[b] = 0;
+
+    Q->ultima = 0;
+    Q->m = 0;
+}
+
+const char *nome_fila(TipoFila tipo) {
+    return operacoes[tipo].nome;
+}
+
+bool fila_por_nome(const char *nome, TipoFila *tipo) {
+    for (int t = 0; t < QTD_TIPOS_FILA; t++) {
+        if (strcmp(nome, operacoes[t].nome) == 0) {
+            *tipo = (TipoFila) t;
+            return true;
+        }
+    }
+    return false;
+}
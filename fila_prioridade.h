@@ -0,0 +1,86 @@
+#ifndef FILA_PRIORIDADE_H
+#define FILA_PRIORIDADE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Filas de prioridade de vértices por chave real (estimativa d), com implementações
+ * intercambiáveis escolhidas em tempo de execução:
+ *
+ *   FILA_BINARIA    heap binária com diminuir_chave (posição de cada vértice em pos[])
+ *   FILA_4ARIA      heap 4-ária com diminuir_chave: menos níveis e os 4 filhos na mesma linha de cache
+ *   FILA_RADIX      radix heap monótona: só aceita chaves >= à última extraída (pesos não negativos)
+ *   FILA_PREGUICOSA heap 4-ária sem diminuir_chave: cada melhora insere uma nova cópia do vértice
+ *
+ * Os itens guardam o par (chave, vértice) dentro do próprio arranjo, sem ponteiros para os
+ * vértices do grafo. Nas heaps, empates na chave são desfeitos pelo índice do vértice.
+ *
+ * Nas filas radix e preguiçosa um vértice pode sair mais de uma vez: quem usa a fila deve
+ * ignorar as cópias de vértices já processados (no Dijkstra, os que já estão em S).
+ */
+
+typedef enum TipoFila {
+    FILA_BINARIA,
+    FILA_4ARIA,
+    FILA_RADIX,
+    FILA_PREGUICOSA,
+    QTD_TIPOS_FILA
+} TipoFila;
+
+typedef struct ItemFila {
+    float chave;
+    int vertice;
+} ItemFila;
+
+typedef struct FilaPrioridade FilaPrioridade;
+typedef struct OperacoesFila OperacoesFila;
+
+struct OperacoesFila {
+    const char *nome;
+    void (*diminuir_chave)(FilaPrioridade *Q, int v, float chave);
+    int (*extrair_minimo)(FilaPrioridade *Q, float *chave);
+};
+
+#define QTD_BALDES_RADIX 33
+
+struct FilaPrioridade {
+    TipoFila tipo;
+    const OperacoesFila *op;
+    int qtd_vertices;
+    int m;               // itens na fila (contando cópias)
+    int capacidade;     // tamanho alocado de itens
+    ItemFila *itens;   // arranjo da heap
+    int *pos;         // posição de cada vértice na heap, -1 se fora (só nas filas com diminuir_chave)
+
+    // Radix heap: balde i guarda chaves que diferem da última extraída a partir do bit i - 1
+    ItemFila *baldes[QTD_BALDES_RADIX];
+    int tam_balde[QTD_BALDES_RADIX], cap_balde[QTD_BALDES_RADIX];
+    uint32_t ultima;
+};
+
+FilaPrioridade *criar_fila_prioridade(TipoFila tipo, int qtd_vertices);
+void desalocar_fila_prioridade(FilaPrioridade *Q);
+
+// Insere v com a chave dada, ou diminui a chave de v se ele já estiver na fila
+static inline void diminuir_chave(FilaPrioridade *Q, int v, float chave) {
+    Q->op->diminuir_chave(Q, v, chave);
+}
+
+// Retorna o vértice de menor chave (guardada em *chave), ou -1 se a fila estiver vazia
+static inline int extrair_minimo(FilaPrioridade *Q, float *chave) {
+    return Q->op->extrair_minimo(Q, chave);
+}
+
+static inline bool fila_vazia(const FilaPrioridade *Q) {
+    return Q->m == 0;
+}
+
+// Esvazia a fila em tempo proporcional aos itens que restam nela, para reaproveitá-la
+void esvaziar_fila(FilaPrioridade *Q);
+
+const char *nome_fila(TipoFila tipo);
+// Retorna false se o nome não corresponder a nenhuma fila
+bool fila_por_nome(const char *nome, TipoFila *tipo);
+
+#endif
@@ -1,55 +1,136 @@
 #include <stdio.h>
 #include <float.h>
 #include <limits.h>
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdbool.h>
 
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86
+#endif
+
+#include "grafo_csr.h"
+#include "leitura_grafo.h"
+#include "cronometro.h"
+
+// Com -q os passos do algoritmo e as matrizes não são exibidos (para medir o tempo em grafos grandes)
+static bool verboso = true;
+
+/*
+ * W e Pi ficam cada uma num único arranjo alinhado, dividido em blocos de TAM_BLOCO x TAM_BLOCO
+ * guardados um depois do outro (cada bloco é contíguo, linha a linha). A quantidade de vértices é
+ * arredondada para um múltiplo de TAM_BLOCO; os vértices de enchimento ficam isolados e nunca
+ * melhoram caminho algum. Os três blocos de W e os dois de Pi usados numa atualização
+ * (cerca de 36 KiB) cabem juntos no L1 de dados.
+ */
+#define TAM_BLOCO 32
+#define ALINHAMENTO 64
+
+/*
+ * Tipo dos elementos de W. Com float e int32 cabem o dobro de elementos em cada vetor SIMD e
+ * os blocos ocupam metade da cache; int32 arredonda os pesos para inteiros e representa o
+ * infinito por INF_INT32, grande o bastante para os caminhos e pequeno o bastante para que a
+ * soma de dois pesos finitos não transborde.
+ */
+typedef enum TipoMatriz {
+    MATRIZ_DOUBLE,
+    MATRIZ_FLOAT,
+    MATRIZ_INT32,
+    QTD_TIPOS_MATRIZ
+} TipoMatriz;
+
+#define INF_INT32 (INT32_MAX / 2)
+
+static const char *nomes_tipos[QTD_TIPOS_MATRIZ] = { "double", "float", "int32" };
+static const size_t tamanhos_tipos[QTD_TIPOS_MATRIZ] = { sizeof(double), sizeof(float), sizeof(int32_t) };
+
 typedef struct Grafo {
-    double **W;
-    int **Pi;
+    void *W;           // elementos do tipo indicado em tipo
+    int *Pi;          // NULL quando só as distâncias são calculadas
+    TipoMatriz tipo;
     int qtd_vertices;
+    int qtd_blocos;   // blocos por linha (e por coluna) da matriz
 } Grafo;
 
-Grafo *criar_grafo(int qtd_vertices) {
+static inline size_t posicao(const Grafo *g, int i, int j) {
+    size_t bloco = (size_t) (i / TAM_BLOCO) * g->qtd_blocos + j / TAM_BLOCO;
+
+    return bloco * TAM_BLOCO * TAM_BLOCO + (i % TAM_BLOCO) * TAM_BLOCO + j % TAM_BLOCO;
+}
+
+// Só vale com g->tipo == MATRIZ_DOUBLE; os outros tipos passam por ler_peso e gravar_peso
+#define W(g, i, j) (((double *) (g)->W)[posicao((g), (i), (j))])
+#define Pi(g, i, j) ((g)->Pi[posicao((g), (i), (j))])
+
+// Qualquer que seja o tipo da matriz, o infinito é devolvido como INFINITY
+static double ler_peso(const Grafo *g, int i, int j) {
+    size_t p = posicao(g, i, j);
+
+    switch (g->tipo) {
+        case MATRIZ_FLOAT:
+            return ((float *) g->W)[p];
+        case MATRIZ_INT32:
+            return ((int32_t *) g->W)[p] == INF_INT32 ? INFINITY : ((int32_t *) g->W)[p];
+        default:
+            return ((double *) g->W)[p];
+    }
+}
+
+static void gravar_peso(Grafo *g, int i, int j, double peso) {
+    size_t p = posicao(g, i, j);
+
+    switch (g->tipo) {
+        case MATRIZ_FLOAT:
+            ((float *) g->W)[p] = (float) peso;
+            break;
+        case MATRIZ_INT32:
+            ((int32_t *) g->W)[p] = isinf(peso) ? INF_INT32 : (int32_t) lrint(peso);
+            break;
+        default:
+            ((double *) g->W)[p] = peso;
+    }
+}
+
+// Sem predecessores, Pi fica NULL e nada além das distâncias é calculado
+Grafo *criar_grafo(int qtd_vertices, TipoMatriz tipo, bool predecessores) {
     Grafo *g = (Grafo *) malloc(sizeof(Grafo));
 
     if (!g) 
         return NULL;
 
+    g->tipo = tipo;
     g->qtd_vertices = qtd_vertices;
-    g->W = (double **) malloc(g->qtd_vertices * sizeof(double *));
-    g->Pi = (int **) malloc(g->qtd_vertices * sizeof(int *));
+    g->qtd_blocos = (qtd_vertices + TAM_BLOCO - 1) / TAM_BLOCO;
 
-    if (!g->W || !g->Pi) {
-        if (g->W)
-            free(g->W);
+    size_t lado = (size_t) g->qtd_blocos * TAM_BLOCO, celulas = lado > 0 ? lado * lado : 1;
+    size_t bytes_W = celulas * tamanhos_tipos[tipo], bytes_Pi = celulas * sizeof(int);
 
-        if (g->Pi)
-            free(g->Pi);
+    // Os tamanhos já são múltiplos de ALINHAMENTO, como aligned_alloc exige
+    g->W = aligned_alloc(ALINHAMENTO, bytes_W < ALINHAMENTO ? ALINHAMENTO : bytes_W);
+    g->Pi = predecessores ? (int *) aligned_alloc(ALINHAMENTO, bytes_Pi < ALINHAMENTO ? ALINHAMENTO : bytes_Pi) : NULL;
 
+    if (!g->W || (predecessores && !g->Pi)) {
+        free(g->W);
+        free(g->Pi);
         free(g);
         return NULL;
     }
 
-    for (int i = 0; i < g->qtd_vertices; i++) {
-        g->W[i] = (double *) malloc(g->qtd_vertices * sizeof(double));
-        g->Pi[i] = (int *) malloc(g->qtd_vertices * sizeof(int));
-
-        if (!g->W[i] || !g->Pi[i]) {
-            for (int j = 0; j < i; j++) {
-                free(g->W[j]);
-                free(g->Pi[j]);
-            }
-            free(g->W);
-            free(g->Pi);
-            free(g);
-            return NULL;
-        }
-
-        for (int j = 0; j < g->qtd_vertices; j++) {
-            g->W[i][j] = (i == j) ? 0 : DBL_MAX;
-            g->Pi[i][j] = -1;
+    for (size_t i = 0; i < lado; i++) {
+        for (size_t j = 0; j < lado; j++) {
+            gravar_peso(g, i, j, (i == j) ? 0 : INFINITY);
+            if (g->Pi)
+                Pi(g, i, j) = -1;
         }
     }
     return g;
@@ -57,32 +138,21 @@ Grafo *criar_grafo(int qtd_vertices) {
 
 void destruir_grafo(Grafo *g) {
     if (g) {
-        for (int i = 0; i < g->qtd_vertices; i++) {
-            if (g->W[i])
-                free(g->W[i]);
-
-            if (g->Pi[i])
-                free(g->Pi[i]);
-        }
-
-        if (g->W)
-            free(g->W);
-        
-        if (g->Pi)
-            free(g->Pi);
-
+        free(g->W);
+        free(g->Pi);
         free(g);
     }
 }
 
-void inserir_aresta(Grafo *g, int eh_grafo_direcionado, int u, int v, double peso) {
-    if (g && g->W && g->W[u] && g->Pi && g->Pi[u]) {
-        g->W[u][v] = peso;
-        g->Pi[u][v] = u;
-
-        if (!eh_grafo_direcionado) {
-            g->W[v][u] = peso;
-            g->Pi[v][u] = v;
+// Copia os arcos da representação CSR para a matriz de pesos (arestas não dirigidas já vêm espelhadas)
+void inserir_arestas(Grafo *g, const GrafoCSR *adj) {
+    if (g) {
+        for (int u = 0; u < adj->qtd_vertices; u++) {
+            for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++) {
+                gravar_peso(g, u, adj->vizinhos[e], adj->pesos[e]);
+                if (g->Pi)
+                    Pi(g, u, adj->vizinhos[e]) = u;
+            }
         }
     }
 }
@@ -101,14 +171,21 @@ void exibir_grafo(Grafo *g) {
         for (int i = 0; i < g->qtd_vertices; i++) {
             printf("%2d |", i);
             for (int j = 0; j < g->qtd_vertices; j++) {
-                if (g->W[i][j] == DBL_MAX) 
+                double w = ler_peso(g, i, j);
+
+                if (w == INFINITY) 
                     printf(" %9s ", "INF");
                 else
-                    printf(" %9lf ", g->W[i][j]);
+                    printf(" %9lf ", w);
             }
             printf("\n");
         }
 
+        if (!g->Pi) {
+            printf("\n");
+            return;
+        }
+
         printf("\nMatriz de predecessores (Pi):\n");
 
         printf("    ");
@@ -119,10 +196,10 @@ void exibir_grafo(Grafo *g) {
         for (int i = 0; i < g->qtd_vertices; i++) {
             printf("%1d |", i);
             for (int j = 0; j < g->qtd_vertices; j++) {
-                if (g->Pi[i][j] == -1) 
+                if (Pi(g, i, j) == -1) 
                     printf(" %4s ", "NULL");
                 else
-                    printf(" %4d ", g->Pi[i][j]);
+                    printf(" %4d ", Pi(g, i, j));
             }
             printf("\n");
         }
@@ -130,22 +207,331 @@ void exibir_grafo(Grafo *g) {
     }
 }
 
+// O laço clássico é a versão de referência e só trabalha com matrizes de double
 void floyd_warshall(Grafo *g) {
-    printf("Algoritmo de Floyd-Warshall prestes a iniciar...\n");
+    if (verboso)
+        printf("Algoritmo de Floyd-Warshall prestes a iniciar...\n");
     for (int k = 0; k < g->qtd_vertices; k++) {
-        printf("[k = %d]\n", k);
+        if (verboso)
+            printf("[k = %d]\n", k);
         for (int i = 0; i < g->qtd_vertices; i++) {
             for (int j = 0; j < g->qtd_vertices; j++) {
-                if (g->W[i][k] + g->W[k][j] < g->W[i][j]) {
-                    printf("W[%d][%d] + W[%d][%d] < W[%d][%d]\n", i, k, k, j, i, j);
-                    g->Pi[i][j] = g->Pi[k][j];
-                    printf("Pi[%d][%d] = Pi[%d][%d]\n", i, j, k, j);
-                    g->W[i][j] = g->W[i][k] + g->W[k][j];
-                    printf("W[%d][%d] = W[%d][%d] + W[%d][%d]\n", i, j, i, k, k, j);
+                if (W(g, i, k) + W(g, k, j) < W(g, i, j)) {
+                    if (verboso)
+                        printf("W[%d][%d] + W[%d][%d] < W[%d][%d]\n", i, k, k, j, i, j);
+                    if (g->Pi) {
+                        Pi(g, i, j) = Pi(g, k, j);
+                        if (verboso)
+                            printf("Pi[%d][%d] = Pi[%d][%d]\n", i, j, k, j);
+                    }
+                    W(g, i, j) = W(g, i, k) + W(g, k, j);
+                    if (verboso)
+                        printf("W[%d][%d] = W[%d][%d] + W[%d][%d]\n", i, j, i, k, k, j);
                 }
             }
         }
-        printf("\n");
+        if (verboso)
+            printf("\n");
+    }
+}
+
+/*
+ * Floyd-Warshall em blocos (Venkataraman, Sahni e Mukhopadhyaya). Para cada bloco diagonal K:
+ *   1. o próprio bloco (K, K) roda o Floyd-Warshall comum sobre os seus k;
+ *   2. os blocos da linha K e da coluna K são atualizados usando o bloco (K, K);
+ *   3. os demais blocos (I, J) são atualizados com os blocos (I, K) e (K, J).
+ * Cada atualização mexe só em três blocos que cabem na cache, em vez de varrer a matriz
+ * inteira para cada k. As distâncias são as mesmas do floyd_warshall(), a menos do
+ * arredondamento de somas feitas em outra ordem; os predecessores também, exceto quando há
+ * mais de um caminho mínimo entre dois vértices e o empate é desfeito de outro jeito.
+ */
+
+static inline void *bloco_W(Grafo *g, int I, int J) {
+    return (char *) g->W + ((size_t) I * g->qtd_blocos + J) * TAM_BLOCO * TAM_BLOCO * tamanhos_tipos[g->tipo];
+}
+
+static inline int *bloco_Pi(Grafo *g, int I, int J) {
+    if (!g->Pi)
+        return NULL;
+    return g->Pi + ((size_t) I * g->qtd_blocos + J) * TAM_BLOCO * TAM_BLOCO;
+}
+
+/*
+ * Atualização de uma linha de C: C[j] = min(C[j], a + B[j]) no sentido min-plus e, onde houve
+ * melhora, Pi_C[j] = Pi_B[j]. Sem predecessores (Pi_C == NULL) só as distâncias mudam. Há uma
+ * versão por tipo da matriz e por conjunto de instruções:
+ *
+ *   escalar  laço comum, com a escolha feita sem desvio
+ *   AVX2     4 double ou 8 float/int32 por instrução; Pi é misturado com a máscara da comparação
+ *   AVX-512  8 double ou 16 float/int32; a máscara da comparação grava Pi direto na memória
+ *
+ * Os blocos são alinhados em 64 bytes e as linhas têm TAM_BLOCO elementos, então todas as
+ * leituras e escritas vetoriais são alinhadas. Em int32 uma soma com B[j] == INF_INT32 nunca é
+ * melhora: a pode ser negativo e a + INF_INT32 passaria por uma distância finita.
+ */
+
+#define DEFINIR_LINHA_ESCALAR(nome, T, INF)                                                     \
+    static inline void nome(T *restrict C, int *restrict Pi_C, T a,                             \
+                            const T *restrict B, const int *restrict Pi_B) {                    \
+        if (Pi_C) {                                                                             \
+            for (int j = 0; j < TAM_BLOCO; j++) {                                               \
+                T soma = a + B[j], atual = C[j];                                                \
+                bool melhora = soma < atual && B[j] != INF;                                     \
+                                                                                                \
+                C[j] = melhora ? soma : atual;                                                  \
+                Pi_C[j] = melhora ? Pi_B[j] : Pi_C[j];                                          \
+            }                                                                                   \
+        } else {                                                                                \
+            for (int j = 0; j < TAM_BLOCO; j++) {                                               \
+                T soma = a + B[j], atual = C[j];                                                \
+                                                                                                \
+                C[j] = soma < atual && B[j] != INF ? soma : atual;                              \
+            }                                                                                   \
+        }                                                                                       \
+    }
+
+DEFINIR_LINHA_ESCALAR(linha_double_escalar, double, INFINITY)
+DEFINIR_LINHA_ESCALAR(linha_float_escalar, float, INFINITY)
+DEFINIR_LINHA_ESCALAR(linha_int32_escalar, int32_t, INF_INT32)
+
+#ifdef KERNELS_X86
+
+#define ALVO_AVX2 __attribute__((target("avx2")))
+#define ALVO_AVX512 __attribute__((target("avx512f")))
+
+ALVO_AVX2
+static inline void linha_double_avx2(double *restrict C, int *restrict Pi_C, double a,
+                                     const double *restrict B, const int *restrict Pi_B) {
+    __m256d va = _mm256_set1_pd(a);
+    // Leva a metade baixa de cada máscara de 64 bits para os quatro primeiros inteiros
+    __m256i compactar = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+    for (int j = 0; j < TAM_BLOCO; j += 4) {
+        __m256d atual = _mm256_load_pd(C + j), soma = _mm256_add_pd(va, _mm256_load_pd(B + j));
+        __m256d melhora = _mm256_cmp_pd(soma, atual, _CMP_LT_OQ);
+
+        _mm256_store_pd(C + j, _mm256_blendv_pd(atual, soma, melhora));
+        if (Pi_C) {
+            __m128i mascara = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(melhora), compactar));
+            __m128i pi = _mm_blendv_epi8(_mm_load_si128((const __m128i *) (Pi_C + j)),
+                                         _mm_load_si128((const __m128i *) (Pi_B + j)), mascara);
+
+            _mm_store_si128((__m128i *) (Pi_C + j), pi);
+        }
+    }
+}
+
+ALVO_AVX2
+static inline void linha_float_avx2(float *restrict C, int *restrict Pi_C, float a,
+                                    const float *restrict B, const int *restrict Pi_B) {
+    __m256 va = _mm256_set1_ps(a);
+
+    for (int j = 0; j < TAM_BLOCO; j += 8) {
+        __m256 atual = _mm256_load_ps(C + j), soma = _mm256_add_ps(va, _mm256_load_ps(B + j));
+        __m256 melhora = _mm256_cmp_ps(soma, atual, _CMP_LT_OQ);
+
+        _mm256_store_ps(C + j, _mm256_blendv_ps(atual, soma, melhora));
+        if (Pi_C) {
+            __m256 pi = _mm256_blendv_ps(_mm256_load_ps((const float *) (Pi_C + j)),
+                                         _mm256_load_ps((const float *) (Pi_B + j)), melhora);
+
+            _mm256_store_ps((float *) (Pi_C + j), pi);
+        }
+    }
+}
+
+ALVO_AVX2
+static inline void linha_int32_avx2(int32_t *restrict C, int *restrict Pi_C, int32_t a,
+                                    const int32_t *restrict B, const int *restrict Pi_B) {
+    __m256i va = _mm256_set1_epi32(a), inf = _mm256_set1_epi32(INF_INT32);
+
+    for (int j = 0; j < TAM_BLOCO; j += 8) {
+        __m256i b = _mm256_load_si256((const __m256i *) (B + j));
+        __m256i atual = _mm256_load_si256((const __m256i *) (C + j)), soma = _mm256_add_epi32(va, b);
+        __m256i melhora = _mm256_andnot_si256(_mm256_cmpeq_epi32(b, inf), _mm256_cmpgt_epi32(atual, soma));
+
+        _mm256_store_si256((__m256i *) (C + j), _mm256_blendv_epi8(atual, soma, melhora));
+        if (Pi_C) {
+            __m256i pi = _mm256_blendv_epi8(_mm256_load_si256((const __m256i *) (Pi_C + j)),
+                                            _mm256_load_si256((const __m256i *) (Pi_B + j)), melhora);
+
+            _mm256_store_si256((__m256i *) (Pi_C + j), pi);
+        }
+    }
+}
+
+// Dois vetores de 8 double por passo, para que as duas máscaras formem uma de 16 inteiros de Pi
+ALVO_AVX512
+static inline void linha_double_avx512(double *restrict C, int *restrict Pi_C, double a,
+                                       const double *restrict B, const int *restrict Pi_B) {
+    __m512d va = _mm512_set1_pd(a);
+
+    for (int j = 0; j < TAM_BLOCO; j += 16) {
+        __m512d atual0 = _mm512_load_pd(C + j), soma0 = _mm512_add_pd(va, _mm512_load_pd(B + j));
+        __m512d atual1 = _mm512_load_pd(C + j + 8), soma1 = _mm512_add_pd(va, _mm512_load_pd(B + j + 8));
+        __mmask8 melhora0 = _mm512_cmp_pd_mask(soma0, atual0, _CMP_LT_OQ);
+        __mmask8 melhora1 = _mm512_cmp_pd_mask(soma1, atual1, _CMP_LT_OQ);
+
+        _mm512_mask_store_pd(C + j, melhora0, soma0);
+        _mm512_mask_store_pd(C + j + 8, melhora1, soma1);
+        if (Pi_C)
+            _mm512_mask_store_epi32(Pi_C + j, (__mmask16) (melhora0 | (melhora1 << 8)), _mm512_load_si512(Pi_B + j));
+    }
+}
+
+ALVO_AVX512
+static inline void linha_float_avx512(float *restrict C, int *restrict Pi_C, float a,
+                                      const float *restrict B, const int *restrict Pi_B) {
+    __m512 va = _mm512_set1_ps(a);
+
+    for (int j = 0; j < TAM_BLOCO; j += 16) {
+        __m512 soma = _mm512_add_ps(va, _mm512_load_ps(B + j));
+        __mmask16 melhora = _mm512_cmp_ps_mask(soma, _mm512_load_ps(C + j), _CMP_LT_OQ);
+
+        _mm512_mask_store_ps(C + j, melhora, soma);
+        if (Pi_C)
+            _mm512_mask_store_epi32(Pi_C + j, melhora, _mm512_load_si512(Pi_B + j));
+    }
+}
+
+ALVO_AVX512
+static inline void linha_int32_avx512(int32_t *restrict C, int *restrict Pi_C, int32_t a,
+                                      const int32_t *restrict B, const int *restrict Pi_B) {
+    __m512i va = _mm512_set1_epi32(a), inf = _mm512_set1_epi32(INF_INT32);
+
+    for (int j = 0; j < TAM_BLOCO; j += 16) {
+        __m512i b = _mm512_load_si512(B + j), soma = _mm512_add_epi32(va, b);
+        __mmask16 melhora = _mm512_mask_cmplt_epi32_mask(_mm512_cmpneq_epi32_mask(b, inf), soma,
+                                                         _mm512_load_si512(C + j));
+
+        _mm512_mask_store_epi32(C + j, melhora, soma);
+        if (Pi_C)
+            _mm512_mask_store_epi32(Pi_C + j, melhora, _mm512_load_si512(Pi_B + j));
+    }
+}
+
+#endif
+
+/*
+ * Atualização de um bloco: C = min(C, A + B), percorrendo os k do bloco diagonal. Na fase 1 e na
+ * linha da fase 2, C é o próprio B (diagonal), e a linha i == k é pulada: ela não mudaria e é a
+ * mesma linha lida em B. Fora isso, a linha k de B (ou a coluna k de A) não muda durante a
+ * iteração k (isso exigiria um ciclo negativo), então as linhas passadas à atualização nunca se
+ * sobrepõem de fato.
+ *
+ * O esqueleto é o mesmo para todos os kernels; cada um é compilado com o seu alvo para que a
+ * atualização de linha seja expandida dentro dele.
+ */
+typedef void (*KernelBloco)(void *C, const void *A, const void *B, int *Pi_C, const int *Pi_B, bool diagonal);
+
+#define DEFINIR_KERNEL(nome, alvo, T, INF, atualizar_linha)                                      \
+    alvo static void nome(void *C, const void *A, const void *B, int *Pi_C, const int *Pi_B,     \
+                          bool diagonal) {                                                       \
+        for (int k = 0; k < TAM_BLOCO; k++) {                                                    \
+            for (int i = 0; i < TAM_BLOCO; i++) {                                                \
+                T a = ((const T *) A)[i * TAM_BLOCO + k];                                        \
+                                                                                                 \
+                if (a == INF || (diagonal && i == k))                                            \
+                    continue;                                                                    \
+                atualizar_linha((T *) C + i * TAM_BLOCO, Pi_C ? Pi_C + i * TAM_BLOCO : NULL, a,  \
+                                (const T *) B + k * TAM_BLOCO, Pi_B ? Pi_B + k * TAM_BLOCO : NULL); \
+            }                                                                                    \
+        }                                                                                        \
+    }
+
+DEFINIR_KERNEL(kernel_double_escalar, , double, INFINITY, linha_double_escalar)
+DEFINIR_KERNEL(kernel_float_escalar, , float, INFINITY, linha_float_escalar)
+DEFINIR_KERNEL(kernel_int32_escalar, , int32_t, INF_INT32, linha_int32_escalar)
+
+#ifdef KERNELS_X86
+DEFINIR_KERNEL(kernel_double_avx2, ALVO_AVX2, double, INFINITY, linha_double_avx2)
+DEFINIR_KERNEL(kernel_float_avx2, ALVO_AVX2, float, INFINITY, linha_float_avx2)
+DEFINIR_KERNEL(kernel_int32_avx2, ALVO_AVX2, int32_t, INF_INT32, linha_int32_avx2)
+DEFINIR_KERNEL(kernel_double_avx512, ALVO_AVX512, double, INFINITY, linha_double_avx512)
+DEFINIR_KERNEL(kernel_float_avx512, ALVO_AVX512, float, INFINITY, linha_float_avx512)
+DEFINIR_KERNEL(kernel_int32_avx512, ALVO_AVX512, int32_t, INF_INT32, linha_int32_avx512)
+#endif
+
+typedef enum Instrucoes {
+    INSTRUCOES_ESCALAR,
+    INSTRUCOES_AVX2,
+    INSTRUCOES_AVX512,
+    QTD_INSTRUCOES
+} Instrucoes;
+
+static const char *nomes_instrucoes[QTD_INSTRUCOES] = { "escalar", "avx2", "avx512" };
+
+// NULL onde o kernel não foi compilado (fora de x86)
+static const KernelBloco kernels[QTD_TIPOS_MATRIZ][QTD_INSTRUCOES] = {
+#ifdef KERNELS_X86
+    [MATRIZ_DOUBLE] = { kernel_double_escalar, kernel_double_avx2, kernel_double_avx512 },
+    [MATRIZ_FLOAT] = { kernel_float_escalar, kernel_float_avx2, kernel_float_avx512 },
+    [MATRIZ_INT32] = { kernel_int32_escalar, kernel_int32_avx2, kernel_int32_avx512 },
+#else
+    [MATRIZ_DOUBLE] = { kernel_double_escalar },
+    [MATRIZ_FLOAT] = { kernel_float_escalar },
+    [MATRIZ_INT32] = { kernel_int32_escalar },
+#endif
+};
+
+// Verifica na CPU (e no sistema, que precisa salvar os registradores largos) se as instruções existem
+static bool instrucoes_disponiveis(Instrucoes instrucoes) {
+    switch (instrucoes) {
+#ifdef KERNELS_X86
+        case INSTRUCOES_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case INSTRUCOES_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        case INSTRUCOES_ESCALAR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static Instrucoes melhores_instrucoes(void) {
+    for (int i = QTD_INSTRUCOES - 1; i > INSTRUCOES_ESCALAR; i--)
+        if (instrucoes_disponiveis(i))
+            return i;
+    return INSTRUCOES_ESCALAR;
+}
+
+static void atualizar_bloco(Grafo *g, KernelBloco kernel, int I, int J, int K) {
+    kernel(bloco_W(g, I, J), bloco_W(g, I, K), bloco_W(g, K, J), bloco_Pi(g, I, J), bloco_Pi(g, K, J), I == K);
+}
+
+/*
+ * As fases são divididas entre as threads: dentro de cada fase os blocos são independentes, e o
+ * fim de cada laço (ou do single) é a barreira que separa uma fase da seguinte. Na fase 3 cada
+ * thread recebe faixas contíguas de linhas de blocos e reaproveita o bloco (I, K) entre os J.
+ */
+void floyd_warshall_blocado(Grafo *g, Instrucoes instrucoes) {
+    KernelBloco kernel = kernels[g->tipo][instrucoes];
+    int n = g->qtd_blocos;
+
+    #pragma omp parallel
+    for (int K = 0; K < n; K++) {
+        #pragma omp single
+        atualizar_bloco(g, kernel, K, K, K);
+
+        // Linha e coluna K num só laço: os n - 1 primeiros índices são os blocos (K, J), os demais os (I, K)
+        #pragma omp for schedule(static)
+        for (int b = 0; b < 2 * (n - 1); b++) {
+            int outro = b % (n - 1);
+
+            outro += outro >= K;
+            if (b < n - 1)
+                atualizar_bloco(g, kernel, K, outro, K);
+            else
+                atualizar_bloco(g, kernel, outro, K, K);
+        }
+
+        #pragma omp for collapse(2) schedule(static)
+        for (int I = 0; I < n; I++)
+            for (int J = 0; J < n; J++)
+                if (I != K && J != K)
+                    atualizar_bloco(g, kernel, I, J, K);
     }
 }
 
@@ -153,10 +539,10 @@ void floyd_warshall(Grafo *g) {
 void exibir_caminho_mais_curto_entre_todos_pares(Grafo *g, int i, int j) { // é o "print_all_pairs_shortest_path" do livro
     if (i == j)
         printf("[%d] ", i);
-    else if (g->Pi[i][j] == -1)	
+    else if (Pi(g, i, j) == -1)	
         printf("Não existe caminho de %d a %d.\n", i, j);
     else 			
-        exibir_caminho_mais_curto_entre_todos_pares(g, i, g->Pi[i][j]);
+        exibir_caminho_mais_curto_entre_todos_pares(g, i, Pi(g, i, j));
     printf("~> %d ", j);
 }
 
@@ -170,25 +556,124 @@ void exibir_todos_caminhos_minimos(Grafo *g) {
     }
 }
 
-int main(void) {
-    int u, v, qtd_vertices, eh_grafo_direcionado;
-    double peso;
+void exibir_uso(const char *programa) {
+    fprintf(stderr, "Uso: %s [-m algoritmo] [-p tipo] [-i instrucoes] [-T threads] [-d] [-q] < grafo\n", programa);
+    fprintf(stderr, "  -m algoritmo   classico (padrão, laço triplo k-i-j) ou blocado (em blocos que cabem na cache)\n");
+    fprintf(stderr, "  -p tipo        tipo das distâncias no modo blocado: double (padrão), float ou int32 (pesos arredondados)\n");
+    fprintf(stderr, "  -i instrucoes  kernel do modo blocado: escalar, avx2 ou avx512 (padrão: o melhor que a CPU suporta)\n");
+    fprintf(stderr, "  -T threads     quantidade de threads do modo blocado\n");
+    fprintf(stderr, "  -d             só as distâncias, sem a matriz de predecessores nem os caminhos\n");
+    fprintf(stderr, "  -q             não exibe os passos, as matrizes nem os caminhos, só o tempo\n");
+}
 
-    fscanf(stdin, "%d %d", &eh_grafo_direcionado, &qtd_vertices);
-    Grafo *g = criar_grafo(qtd_vertices);
+int main(int argc, char *argv[]) {
+    bool blocado = false, predecessores = true;
+    TipoMatriz tipo = MATRIZ_DOUBLE;
+    Instrucoes instrucoes = melhores_instrucoes();
+    int qtd_threads = 1, opcao;
 
-    while (fscanf(stdin, "%d %d %lf", &u, &v, &peso) != EOF) {
-        if (u < g->qtd_vertices && v < g->qtd_vertices) {
-            inserir_aresta(g, eh_grafo_direcionado, u, v, peso);
-		    printf("Aresta (%d,%d) com peso w(%d,%d) = %lf adicionada ao grafo.\n", u, v, u, v, peso);
+    while ((opcao = getopt(argc, argv, "m:p:i:T:dq")) != -1) {
+        switch (opcao) {
+            case 'm':
+                if (strcmp(optarg, "classico") == 0)
+                    blocado = false;
+                else if (strcmp(optarg, "blocado") == 0)
+                    blocado = true;
+                else {
+                    exibir_uso(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                for (tipo = 0; tipo < QTD_TIPOS_MATRIZ && strcmp(optarg, nomes_tipos[tipo]) != 0; tipo++)
+                    ;
+                if (tipo == QTD_TIPOS_MATRIZ) {
+                    exibir_uso(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'i':
+                for (instrucoes = 0; instrucoes < QTD_INSTRUCOES && strcmp(optarg, nomes_instrucoes[instrucoes]) != 0; instrucoes++)
+                    ;
+                if (instrucoes == QTD_INSTRUCOES) {
+                    exibir_uso(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                if (!instrucoes_disponiveis(instrucoes) || !kernels[MATRIZ_DOUBLE][instrucoes]) {
+                    fprintf(stderr, "As instruções %s não estão disponíveis nesta máquina.\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'T':
+#ifdef _OPENMP
+                omp_set_num_threads(atoi(optarg));
+#endif
+                break;
+            case 'd':
+                predecessores = false;
+                break;
+            case 'q':
+                verboso = false;
+                break;
+            default:
+                exibir_uso(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!blocado && tipo != MATRIZ_DOUBLE) {
+        fprintf(stderr, "Os tipos float e int32 só existem no modo blocado (-m blocado).\n");
+        return EXIT_FAILURE;
+    }
+
+    // Entrada em texto (.graph) ou no formato binário gerado pelo converter_grafo
+    GrafoCSR *adj = carregar_grafo(STDIN_FILENO, true);
+
+    if (!adj)
+        return EXIT_FAILURE;
+
+    int qtd_vertices = adj->qtd_vertices;
+
+    for (int u = 0; verboso && u < adj->qtd_vertices; u++) {
+        for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++) {
+            if (adj->eh_dirigido || u <= adj->vizinhos[e])
+		        printf("Aresta (%d,%d) com peso w(%d,%d) = %lf adicionada ao grafo.\n", u, adj->vizinhos[e], u, adj->vizinhos[e], adj->pesos[e]);
         }
 	}
 
-    exibir_grafo(g);
-    floyd_warshall(g);
-    exibir_grafo(g);
-    exibir_todos_caminhos_minimos(g);
-    printf("\n");
+    Grafo *g = criar_grafo(qtd_vertices, tipo, predecessores);
+    assert(g != NULL);
+
+    inserir_arestas(g, adj);
+    desalocar_grafo_csr(adj);
+
+    if (verboso)
+        exibir_grafo(g);
+
+#ifdef _OPENMP
+    qtd_threads = omp_get_max_threads();
+#endif
+
+    double inicio = tempo_atual();
+    if (blocado)
+        floyd_warshall_blocado(g, instrucoes);
+    else
+        floyd_warshall(g);
+    double fim = tempo_atual();
+
+    if (verboso) {
+        exibir_grafo(g);
+        if (g->Pi) {
+            exibir_todos_caminhos_minimos(g);
+            printf("\n");
+        }
+    } else if (blocado)
+        printf("Floyd-Warshall blocado (%s, %s, %d thread%s%s) com %d vértices: %.3f s\n", nomes_tipos[tipo],
+               nomes_instrucoes[instrucoes], qtd_threads, qtd_threads > 1 ? "s" : "", g->Pi ? "" : ", só distâncias",
+               qtd_vertices, fim - inicio);
+    else
+        printf("Floyd-Warshall clássico%s com %d vértices: %.3f s\n", g->Pi ? "" : " (só distâncias)", qtd_vertices, fim - inicio);
+
     destruir_grafo(g);
 
     return EXIT_SUCCESS;
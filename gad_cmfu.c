@@ -1,279 +1,183 @@
 #include <stdio.h>
 #include <float.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <stdbool.h>
 
-#define BRANCO 'b'
-#define PRETO 'p'
-#define CINZA 'c'
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "grafo_csr.h"
+#include "leitura_grafo.h"
+#include "ordem_topologica.h"
+#include "cronometro.h"
+
+// Com -q não são exibidos o grafo, a ordenação e a tabela de distâncias, só o resumo e o tempo
+static bool verboso = true;
+
+// Níveis com menos vértices que isso são processados por uma thread só
+#define NIVEL_PARALELO_GAD 1024
 
 typedef struct Grafo Grafo;
 typedef struct Vertice Vertice;
-typedef struct No No;
 
 struct Grafo {
 	int qtd_vertices;
 	Vertice *vertices;
+	GrafoCSR *adj;  // arcos de u em adj->vizinhos/adj->pesos[adj->inicio[u] .. adj->inicio[u + 1] - 1]
+	GrafoCSR *adj_entrada;  // arcos que chegam em cada vértice (o transposto), montados pelo gad_caminhos()
 };
 
 struct Vertice {
-    char cor;
-    int td, tf;
 	float d;
 	int pai;
-	No *lista_adjacencia;
 };
 
-struct No {
-	int vertice;
-	float peso;
-	No *proximo_no;
-};
+Grafo *criar_grafo(GrafoCSR *adj) {  // O grafo passa a ser dono de adj
+	if (!adj)
+		return NULL;
 
-Grafo *criar_grafo(int qtd_vertices) {
 	Grafo *g = (Grafo *) malloc(sizeof(Grafo));
 
 	if (g) {
-    	g->vertices = (Vertice *) malloc(qtd_vertices * sizeof(Vertice));
+		g->vertices = (Vertice *) malloc(adj->qtd_vertices * sizeof(Vertice));
 
-    	if (g->vertices) {
-        	g->qtd_vertices = qtd_vertices;
-
-        	for (int i = 0; i < g->qtd_vertices; i++)
-            	g->vertices[i].lista_adjacencia = NULL;
-       	 
-        	return g;
-    	}
-    	free(g);
+		if (g->vertices) {
+			g->qtd_vertices = adj->qtd_vertices;
+			g->adj = adj;
+			g->adj_entrada = NULL;
+			return g;
+		}
+		free(g);
 	}
+	desalocar_grafo_csr(adj);
 
 	return NULL;
 }
 
 void desalocar_grafo(Grafo *g) {
 	if (g) {
-    	if (g->vertices) {
-        	No *no_atual = NULL, *prox = NULL;
-       	 
-        	for (int i = 0; i < g->qtd_vertices; i++) {
-            	no_atual = g->vertices[i].lista_adjacencia;
-
-            	while (no_atual) {
-                	prox = no_atual->proximo_no;
-                	free(no_atual);
-                	no_atual = prox;
-            	}
-        	}
-        	free(g->vertices);
-    	}
-    	free(g);
-	}
-}
-
-No *criar_no(int vertice) {  // "vertice" é a posição do vértice vizinho no array
-    No *novo_no = (No *) malloc(sizeof(No));
-
-    if (novo_no) {
-        novo_no->vertice = vertice;
-        novo_no->proximo_no = NULL;
-        return novo_no;
-    }
-    return NULL;
-}
-
-No *criar_no_adjacente(int vertice, float peso) {  // "vertice" é a posição do vértice vizinho no array
-	No *novo_no = (No *) malloc(sizeof(No));
-
-	if (novo_no) {
-    	novo_no->vertice = vertice;
-    	novo_no->peso = peso;
-    	novo_no->proximo_no = NULL;
-    	return novo_no;
-	}
-	return NULL;
-}
-
-int aresta_existe(Grafo *g, int u, int v) {
-	No *no_atual = g->vertices[u].lista_adjacencia;
-    
-	// Percorre a lista adj. de u para verificar se v já está nela
-	while (no_atual) {
-    	if (no_atual->vertice == v)
-        	return 1; // (u,v) já existe   
-    	no_atual = no_atual->proximo_no;
+		desalocar_grafo_csr(g->adj);
+		desalocar_grafo_csr(g->adj_entrada);
+		free(g->vertices);
+		free(g);
 	}
-	return 0; // (u,v) não existe no grafo
 }
 
-void inserir_aresta(Grafo *g, int eh_grafo_dirigido, int u, int v, float peso) {
-	if (g && !aresta_existe(g, u, v)) {
-    	No *vizinho = criar_no_adjacente(v, peso);
-
-    	if (vizinho) {
-        	// Colocando v na lista adj. de u
-        	vizinho->proximo_no = g->vertices[u].lista_adjacencia;
-        	g->vertices[u].lista_adjacencia = vizinho;
-       	 
-        	// Coloca u na lista adj. de v quando o grafo for simples
-        	vizinho = criar_no_adjacente(u, peso);
-        	if (!eh_grafo_dirigido && vizinho) {
-            	vizinho->proximo_no = g->vertices[v].lista_adjacencia;
-            	g->vertices[v].lista_adjacencia = vizinho;
-        	}
-    	}
-	}
-}
-
-void inserir_no_inicio(No **cabeca, No *novo_no) {
-    if (cabeca && novo_no) {
-
-        // Lista vazia
-        if (!*cabeca) {
-            *cabeca = novo_no;
-        } else { // Lista não vazia
-            novo_no->proximo_no = *cabeca;
-            *cabeca = novo_no;
-        }
-    }
-}
-
-void exibir_ordenacao_topologica(No *lista_ordenada) {
+void exibir_ordenacao_topologica(const OrdemTopologica *o) {
     printf("Resultado final da ordenação topológica:\n\n");
-    
-    No *atual = lista_ordenada;
 
     printf("[L]");
-    while (atual) {
-        printf(" ~> %d", atual->vertice);
-        atual = atual->proximo_no;
-    }
+    for (int i = 0; i < o->qtd_ordenados; i++)
+        printf(" ~> %d", o->ordem[i]);
+    printf("\n\n");
 
+    for (int k = 0; k < o->qtd_niveis; k++) {
+        printf("Nível %d:", k);
+        for (int i = o->inicio_nivel[k]; i < o->inicio_nivel[k + 1]; i++)
+            printf(" %d", o->ordem[i]);
+        printf("\n");
+    }
     printf("\n");
 }
 
-void visita_dfs_topologica(Grafo *g, int u, int *tempo, No **lista_ordenada) {
-    printf("O vértice %d tem cor '%c'\n", u, g->vertices[u].cor);
-
-    (*tempo)++;
-    g->vertices[u].td = *tempo;
-    g->vertices[u].cor = CINZA;
-    
-    printf("Descobrindo o vértice %d, agora de cor '%c', sendo seu tempo de descoberta td = %d\n", 
-    u, g->vertices[u].cor, g->vertices[u].td);
-
-    No *v = g->vertices[u].lista_adjacencia;
+// Ordenação topológica por níveis (algoritmo de Kahn, em ordem_topologica.c); num grafo com ciclo, exibe o ciclo
+OrdemTopologica *ordenacao_topologica(Grafo *g) {
+    bool paralelo = false;
+#ifdef _OPENMP
+    paralelo = omp_get_max_threads() > 1;
+#endif
 
-    printf("A exploração dos vértices vizinhos do vértice %d será iniciada.\n", u);
+    if (verboso)
+        printf("Ordenação topológica prestes a iniciar.\n");
 
-    while (v) {
-        if (g->vertices[v->vertice].cor == BRANCO) {
-            g->vertices[v->vertice].pai = u;
-            visita_dfs_topologica(g, v->vertice, tempo, lista_ordenada);
-        }
-        v = v->proximo_no;
-    }
+    OrdemTopologica *o = ordenar_por_niveis(g->adj, paralelo);
 
-    g->vertices[u].cor = PRETO;
-    (*tempo)++;
-    g->vertices[u].tf = *tempo;
+    if (!o)
+        return NULL;
 
-    printf("O vértice %d foi totalmente processado, tendo tempo de finalização tf = %d e agora cor '%c'\n",
-    u, g->vertices[u].tf, g->vertices[u].cor);
+    if (o->tam_ciclo > 0) {
+        printf("O grafo tem um ciclo, então não é um GAD (%d de %d vértices ordenados):\n",
+               o->qtd_ordenados, o->qtd_vertices);
+        for (int i = 0; i < o->tam_ciclo; i++)
+            printf("%d -> ", o->ciclo[i]);
+        printf("%d\n", o->ciclo[0]);
+    } else if (verboso)
+        exibir_ordenacao_topologica(o);
 
-
-    // Coloca o vértice u no início da lista topológica (ordena em ordem inversa de finalzação)
-    printf("Inserindo o vértice %d no início da lista topológica\n", u);
-    No *novo_no = criar_no(u);
-    inserir_no_inicio(lista_ordenada, novo_no);
+    return o;
 }
 
-No *ordenacao_topologica(Grafo *g) {
-    printf("Ordenação topológica prestes a iniciar.\n");
+typedef enum TipoCaminho {
+    CAMINHO_MINIMO,
+    CAMINHO_CRITICO,   // caminho mais longo, o que define a duração de um conjunto de tarefas dependentes
+} TipoCaminho;
 
-    printf("Iniciando a busca em profundidade.\n\n");
+// d = 0 nas fontes e FLT_MAX (não alcançado) nos demais vértices
+void inicializar_fontes(Grafo *g, const int *fontes, int qtd_fontes) {
+    #pragma omp parallel for
     for (int i = 0; i < g->qtd_vertices; i++) {
-        g->vertices[i].cor = BRANCO;
+        g->vertices[i].d = FLT_MAX;
         g->vertices[i].pai = -1;
-        printf("O vértice %d recebeu cor '%c' e tem pai desconhecido\n", i, g->vertices[i].cor);
     }
+    for (int i = 0; i < qtd_fontes; i++)
+        g->vertices[fontes[i]].d = 0;
+}
 
-    No *lista_ordenada = NULL;
-    int tempo = 0;
-
-    printf("\nComeçando a vista de vértices brancos\n");
-    for (int i = 0; i < g->qtd_vertices; i++)
-        if (g->vertices[i].cor == BRANCO)
-            visita_dfs_topologica(g, i, &tempo, &lista_ordenada);
+/*
+ * Relaxamento "puxado": v olha todos os arcos que chegam nele de uma vez e fica com o melhor.
+ * Os predecessores estão em níveis anteriores, já finalizados, e só a thread de v escreve em v,
+ * então não há disputa entre threads. O valor inicial de v (0 numa fonte) também concorre.
+ */
+static inline void puxar(Grafo *g, int v, TipoCaminho tipo) {
+    const GrafoCSR *entrada = g->adj_entrada;
+    float melhor = g->vertices[v].d;
+    int pai = -1;
 
-    printf("\nBusca em profundidade concluída.\n\n\n");
+    for (int e = entrada->inicio[v]; e < entrada->inicio[v + 1]; e++) {
+        int u = entrada->vizinhos[e];
+        float d_u = g->vertices[u].d;
 
+        if (d_u == FLT_MAX)
+            continue;   // u não é alcançável a partir das fontes
 
-    printf("Resultado final do algoritmo de busca em profundidade:\n\n");
+        float d = d_u + entrada->pesos[e];
 
-    for (int i = 0; i < g->qtd_vertices; i++) {
-        printf("O vértice %d terminou com cor '%c', tendo td = %d, tf = %d e vértice pai %d\n", 
-        i, g->vertices[i].cor, g->vertices[i].td, g->vertices[i].tf, g->vertices[i].pai);
+        if (melhor == FLT_MAX || (tipo == CAMINHO_MINIMO ? d < melhor : d > melhor)) {
+            melhor = d;
+            pai = u;
+        }
     }
 
-    printf("\n\n");
-
-    exibir_ordenacao_topologica(lista_ordenada);
-
-    return lista_ordenada;
+    g->vertices[v].d = melhor;
+    g->vertices[v].pai = pai;
 }
 
-void desalocar_lista(No *lista_ordenada) {
-    while (lista_ordenada) {
-        No *temp = lista_ordenada;
+void exibir_arestas(Grafo *g) {
+	for (int u = 0; u < g->qtd_vertices; u++) {
+		for (int e = g->adj->inicio[u]; e < g->adj->inicio[u + 1]; e++) {
+			int v = g->adj->vizinhos[e];
 
-        lista_ordenada = lista_ordenada->proximo_no;
-        free(temp);
-    }
-}
-
-void inicializar_fonte_unica(Grafo *g, int s) {
-	printf("O inicializar_fonte_unica está prestes a executar.\n");
-	for (int i = 0; i < g->qtd_vertices; i++) {
-    	g->vertices[i].d = FLT_MAX;
-    	g->vertices[i].pai = -1;
-		printf("O vértice %d tem pai %d e estimativa inicial de %f.\n", i, g->vertices[i].pai, g->vertices[i].d);
+			if (g->adj->eh_dirigido || u <= v)  // cada aresta não dirigida aparece uma vez só
+				printf("Aresta (%d,%d) com peso w(%d,%d) = %f adicionada ao grafo.\n", u, v, u, v, g->adj->pesos[e]);
+		}
 	}
-	g->vertices[s].d = 0;
-	printf("O vértice fonte s = %d teve sua estimativa atualizada para %f\n", s, g->vertices[s].d);
-	printf("inicializar_fonte_unica totalmente finalizado.\n\n");
-}
-
-void relaxar(Grafo *g, int u, int v, float peso) {
-	printf("Estimativa do vértice v = %d: %f.\n", v, g->vertices[v].d);
-	printf("Estimativa do vértive u = %d: %f.\n", u, g->vertices[u].d);
-	printf("w(%d,%d) = %f.\n", u, v, peso);
-
-	if (g->vertices[v].d > g->vertices[u].d + peso) {
-		printf("A aresta (%d,%d) com peso w(%d,%d) = %f irá relaxar, pois %f > %f + (%f).\n", 
-		u, v, u, v, peso, g->vertices[v].d, g->vertices[u].d, peso);
-
-    	g->vertices[v].d = g->vertices[u].d + peso;
-    	g->vertices[v].pai = u;
-	} else
-		printf("A aresta (%d,%d) com peso w(%d,%d) = %f não sofreu relaxamento.\n",
-		u, v, u, v, peso);
+	printf("\n");
 }
 
 void exibir_lista_adjacencia(Grafo *g) {
 	if (g) {
-    	No *no_atual = NULL;
-
-    	for (int i = 0; i < g->qtd_vertices; i++) {
-        	no_atual = g->vertices[i].lista_adjacencia;
-        	printf("\n[%d]", i);
-
-        	while (no_atual) {
-            	printf(" ~> [%d, %f]", no_atual->vertice, no_atual->peso);
-            	no_atual = no_atual->proximo_no;
-        	}
-    	}
-    	printf("\n\n");
+		for (int i = 0; i < g->qtd_vertices; i++) {
+			printf("\n[%d]", i);
+
+			for (int e = g->adj->inicio[i]; e < g->adj->inicio[i + 1]; e++)
+				printf(" ~> [%d, %f]", g->adj->vizinhos[e], g->adj->pesos[e]);
+		}
+		printf("\n\n");
 	}
 }
 
@@ -301,48 +205,170 @@ void exibir_resumo_grafo(Grafo *g) {
     }
 }
 
-void gad_caminho_minimo(Grafo *g, int s) {
-    No *lista_ordenada = ordenacao_topologica(g);
+/*
+ * Caminhos mínimos (ou críticos) num GAD a partir de uma ou mais fontes, nível a nível da
+ * ordenação topológica: os vértices de um nível não dependem uns dos outros, então cada nível
+ * grande é dividido entre as threads. Num grafo com ciclo retorna false (também se faltar
+ * memória). O transposto fica em g para as próximas chamadas.
+ */
+bool gad_caminhos(Grafo *g, const OrdemTopologica *o, const int *fontes, int qtd_fontes, TipoCaminho tipo) {
+    if (o->tam_ciclo > 0)
+        return false;
+    if (!g->adj_entrada && !(g->adj_entrada = transpor_grafo_csr(g->adj)))
+        return false;
+
+    inicializar_fontes(g, fontes, qtd_fontes);
+
+    for (int k = 0; k < o->qtd_niveis; k++) {
+        int ini = o->inicio_nivel[k], fim = o->inicio_nivel[k + 1];
+
+        #pragma omp parallel for schedule(dynamic, 256) if (fim - ini >= NIVEL_PARALELO_GAD)
+        for (int i = ini; i < fim; i++)
+            puxar(g, o->ordem[i], tipo);
+    }
+    return true;
+}
 
-    inicializar_fonte_unica(g, s);
-    
-    printf("Processamento dos vértices em ordem topológica prestes a começar.\n");
-    No *v = NULL;
-    for (No *u = lista_ordenada; u != NULL; u = u->proximo_no) {
-
-        v = g->vertices[u->vertice].lista_adjacencia;
-        while (v) {
-            relaxar(g, u->vertice, v->vertice, v->peso);
-            v = v->proximo_no;
-        }
+// Lê uma lista de vértices separados por vírgulas; retorna a quantidade, ou -1 se algum for inválido
+int ler_fontes(const char *texto, int **fontes) {
+    int qtd = 1;
+
+    for (const char *c = texto; *c; c++)
+        qtd += *c == ',';
+
+    *fontes = (int *) realloc(*fontes, qtd * sizeof(int));
+    assert(*fontes != NULL);
+
+    const char *c = texto;
+    for (int i = 0; i < qtd; i++) {
+        char *fim;
+        long v = strtol(c, &fim, 10);
+
+        if (fim == c || (*fim != ',' && *fim != '\0') || v < 0 || v > 2147483647L)
+            return -1;
+        (*fontes)[i] = (int) v;
+        c = fim + 1;
     }
+    return qtd;
+}
 
-    printf("Algoritmo para cmfu em gad finalizado.\n");
-    desalocar_lista(lista_ordenada);
+void exibir_uso(const char *programa) {
+    fprintf(stderr, "Uso: %s [-s fontes | -r] [-c] [-T threads] [-q] < grafo\n", programa);
+    fprintf(stderr, "  -s fontes   vértices de origem separados por vírgulas (padrão 1)\n");
+    fprintf(stderr, "  -r          usa como fontes todos os vértices sem arcos de entrada\n");
+    fprintf(stderr, "  -c          caminho crítico (o mais longo) em vez do mínimo\n");
+    fprintf(stderr, "  -T threads  quantidade de threads da ordenação e dos níveis\n");
+    fprintf(stderr, "  -q          exibe só o resumo e o tempo\n");
 }
 
-int main(void) {
-	int eh_grafo_direcionado, qtd_vertices, u, v;
-	float peso = 0;
-    
-	if (fscanf(stdin, "%d %d", &eh_grafo_direcionado, &qtd_vertices) == 2) {
-    	Grafo *g = criar_grafo(qtd_vertices);
-   	 
-    	while (fscanf(stdin, "%d %d %f", &u, &v, &peso) != EOF) {
-        	inserir_aresta(g, eh_grafo_direcionado, u, v, peso);
-			printf("Aresta (%d,%d) com peso w(%d,%d) = %f adicionada ao grafo.\n", u, v, u, v, peso);
+int main(int argc, char *argv[]) {
+	TipoCaminho tipo = CAMINHO_MINIMO;
+	int *fontes = NULL, qtd_fontes = 0, opcao;
+	bool raizes = false;
+
+	while ((opcao = getopt(argc, argv, "s:rcT:q")) != -1) {
+		switch (opcao) {
+			case 's':
+				if ((qtd_fontes = ler_fontes(optarg, &fontes)) < 0) {
+					fprintf(stderr, "Lista de fontes inválida: %s\n", optarg);
+					free(fontes);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 'r':
+				raizes = true;
+				break;
+			case 'c':
+				tipo = CAMINHO_CRITICO;
+				break;
+			case 'T':
+#ifdef _OPENMP
+				omp_set_num_threads(atoi(optarg));
+#endif
+				break;
+			case 'q':
+				verboso = false;
+				break;
+			default:
+				exibir_uso(argv[0]);
+				free(fontes);
+				return EXIT_FAILURE;
+		}
+	}
+
+	// Entrada em texto (.graph) ou no formato binário gerado pelo converter_grafo
+	Grafo *g = criar_grafo(carregar_grafo(STDIN_FILENO, true));
+
+	if (!g) {
+		free(fontes);
+		return EXIT_FAILURE;
+	}
+
+	if (qtd_fontes == 0 && !raizes)
+		qtd_fontes = ler_fontes("1", &fontes);   // a fonte fixa da versão original
+	for (int i = 0; i < qtd_fontes; i++) {
+		if (fontes[i] >= g->qtd_vertices) {
+			fprintf(stderr, "Vértice fonte %d fora do intervalo [0, %d).\n", fontes[i], g->qtd_vertices);
+			free(fontes);
+			desalocar_grafo(g);
+			return EXIT_FAILURE;
 		}
-		printf("\n");
+	}
+
+	if (verboso) {
+		exibir_arestas(g);
 
 		printf("Grafo de entrada:");
 		exibir_lista_adjacencia(g);
+	}
 
-        gad_caminho_minimo(g, 1);
+	// O transposto é montado fora da medição, como a leitura do grafo
+	g->adj_entrada = transpor_grafo_csr(g->adj);
 
-		exibir_resumo_grafo(g);
-    	desalocar_grafo(g);
-   	 
-    	return EXIT_SUCCESS;
+	double inicio = tempo_atual();
+	OrdemTopologica *o = ordenacao_topologica(g);
+	double fim_ordenacao = tempo_atual();
+
+	if (o && raizes) {
+		// As fontes são o nível 0 da ordenação (vértices sem arcos de entrada)
+		qtd_fontes = o->tam_ciclo == 0 && o->qtd_niveis > 0 ? o->inicio_nivel[1] : 0;
+		fontes = (int *) realloc(fontes, (qtd_fontes > 0 ? qtd_fontes : 1) * sizeof(int));
+		assert(fontes != NULL);
+		memcpy(fontes, o->ordem, qtd_fontes * sizeof(int));
 	}
-	return EXIT_FAILURE;
-}
\ No newline at end of file
+
+	bool ok = o && g->adj_entrada && gad_caminhos(g, o, fontes, qtd_fontes, tipo);
+	double fim = tempo_atual();
+
+	if (ok) {
+		if (verboso)
+			exibir_resumo_grafo(g);
+
+		// Resumo: o vértice alcançado mais distante (o fim do caminho crítico, com -c)
+		int alcancados = 0, extremo = -1;
+		for (int v = 0; v < g->qtd_vertices; v++) {
+			if (g->vertices[v].d == FLT_MAX)
+				continue;
+			alcancados++;
+			if (extremo == -1 || g->vertices[v].d > g->vertices[extremo].d)
+				extremo = v;
+		}
+
+		int qtd_threads = 1;
+#ifdef _OPENMP
+		qtd_threads = omp_get_max_threads();
+#endif
+		printf("%sCaminhos %s a partir de %d fonte%s (%d thread%s): %d vértices alcançados",
+		       verboso ? "\n" : "", tipo == CAMINHO_CRITICO ? "críticos" : "mínimos", qtd_fontes,
+		       qtd_fontes != 1 ? "s" : "", qtd_threads, qtd_threads > 1 ? "s" : "", alcancados);
+		if (extremo != -1)
+			printf(", o mais distante é %d com d = %f", extremo, g->vertices[extremo].d);
+		printf(", %.3f s (ordenação: %.3f s)\n", fim - inicio, fim_ordenacao - inicio);
+	} else if (o && o->tam_ciclo == 0)
+		fprintf(stderr, "Memória insuficiente.\n");
+
+	desalocar_ordem_topologica(o);
+	free(fontes);
+	desalocar_grafo(g);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
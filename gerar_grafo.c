@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * Gera grafos sintéticos no formato .graph para medir o desempenho dos programas:
+ *
+ *   grade L       grade L x L não dirigida, cada vértice ligado aos 4 vizinhos
+ *                 (parecida com uma malha viária: grau baixo e diâmetro grande)
+ *   rmat E F      grafo R-MAT dirigido com 2^E vértices e F * 2^E arestas
+ *                 (grau em lei de potência e diâmetro pequeno, como redes sociais)
+ *   gad V F       grafo acíclico dirigido com V vértices e cerca de F * V arcos, cada um
+ *                 de u para um dos 2000 vértices seguintes (como dependências de tarefas)
+ *
+ * Os pesos são inteiros sorteados em [1, 100]. A semente fixa torna a saída reproduzível.
+ */
+
+static uint64_t estado = 88172645463325252ull;
+
+static uint64_t sortear(void) {  // xorshift64*
+    estado ^= estado >> 12;
+    estado ^= estado << 25;
+    estado ^= estado >> 27;
+    return estado * 2685821657736338717ull;
+}
+
+static double sortear_real(void) {
+    return (sortear() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int sortear_peso(void) {
+    return 1 + (int) (sortear() % 100);
+}
+
+static void gerar_grade(int lado) {
+    printf("0\n%d\n", lado * lado);
+
+    for (int i = 0; i < lado; i++) {
+        for (int j = 0; j < lado; j++) {
+            int u = i * lado + j;
+
+            if (j + 1 < lado)
+                printf("%d %d %d\n", u, u + 1, sortear_peso());
+            if (i + 1 < lado)
+                printf("%d %d %d\n", u, u + lado, sortear_peso());
+        }
+    }
+}
+
+// Probabilidades (a, b, c, d) = (0.57, 0.19, 0.19, 0.05) dos quadrantes, as do Graph500
+static void gerar_rmat(int escala, int fator) {
+    long qtd_vertices = 1L << escala, qtd_arestas = (long) fator << escala;
+
+    printf("1\n%ld\n", qtd_vertices);
+
+    for (long k = 0; k < qtd_arestas; k++) {
+        long u = 0, v = 0;
+
+        for (int bit = 0; bit < escala; bit++) {
+            double r = sortear_real();
+
+            if (r < 0.57) {
+                // quadrante superior esquerdo: nenhum bit
+            } else if (r < 0.76) {
+                v |= 1L << bit;
+            } else if (r < 0.95) {
+                u |= 1L << bit;
+            } else {
+                u |= 1L << bit;
+                v |= 1L << bit;
+            }
+        }
+        printf("%ld %ld %d\n", u, v, sortear_peso());
+    }
+}
+
+// Os arcos só vão de u para vértices maiores, então a ordem 0, 1, ..., V - 1 é topológica
+static void gerar_gad(int qtd_vertices, int fator) {
+    printf("1\n%d\n", qtd_vertices);
+
+    for (int u = 0; u < qtd_vertices; u++) {
+        for (int k = 0; k < fator; k++) {
+            long v = u + 1 + (long) (sortear() % 2000);
+
+            if (v < qtd_vertices)
+                printf("%d %ld %d\n", u, v, sortear_peso());
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "grade") == 0) {
+        if (argc > 3)
+            estado = strtoull(argv[3], NULL, 10) | 1;
+        gerar_grade(atoi(argv[2]));
+    } else if (argc >= 4 && strcmp(argv[1], "rmat") == 0) {
+        if (argc > 4)
+            estado = strtoull(argv[4], NULL, 10) | 1;
+        gerar_rmat(atoi(argv[2]), atoi(argv[3]));
+    } else if (argc >= 4 && strcmp(argv[1], "gad") == 0) {
+        if (argc > 4)
+            estado = strtoull(argv[4], NULL, 10) | 1;
+        gerar_gad(atoi(argv[2]), atoi(argv[3]));
+    } else {
+        fprintf(stderr, "Uso: %s grade L [semente]\n", argv[0]);
+        fprintf(stderr, "     %s rmat E F [semente]\n", argv[0]);
+        fprintf(stderr, "     %s gad V F [semente]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,300 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/mman.h>
+
+#include "grafo_csr.h"
+
+#define CAPACIDADE_INICIAL 1024
+#define BITS_DIGITO 11
+#define TAM_DIGITO (1 << BITS_DIGITO)
+
+ListaArestas *criar_lista_arestas(int qtd_vertices, int eh_dirigido, bool ponderado) {
+    ListaArestas *l = (ListaArestas *) malloc(sizeof(ListaArestas));
+
+    if (l) {
+        l->arestas = (Aresta *) malloc(CAPACIDADE_INICIAL * sizeof(Aresta));
+
+        if (l->arestas) {
+            l->qtd_vertices = qtd_vertices;
+            l->eh_dirigido = eh_dirigido;
+            l->ponderado = ponderado;
+            l->qtd = 0;
+            l->capacidade = CAPACIDADE_INICIAL;
+            return l;
+        }
+        free(l);
+    }
+    return NULL;
+}
+
+void desalocar_lista_arestas(ListaArestas *l) {
+    if (l) {
+        free(l->arestas);
+        free(l);
+    }
+}
+
+int adicionar_aresta(ListaArestas *l, int u, int v, float peso) {
+    if (u < 0 || v < 0 || u >= l->qtd_vertices || v >= l->qtd_vertices)
+        return 0;
+
+    if (l->qtd == l->capacidade) {
+        // Dobra a capacidade para que o custo amortizado da inserção seja O(1)
+        Aresta *novo = (Aresta *) realloc(l->arestas, 2 * (size_t) l->capacidade * sizeof(Aresta));
+
+        if (!novo)
+            return 0;
+
+        l->arestas = novo;
+        l->capacidade *= 2;
+    }
+
+    l->arestas[l->qtd].u = u;
+    l->arestas[l->qtd].v = v;
+    l->arestas[l->qtd].peso = peso;
+    l->qtd++;
+
+    return 1;
+}
+
+static GrafoCSR *alocar_grafo_csr(int qtd_vertices, int qtd_arcos, int eh_dirigido, bool ponderado) {
+    GrafoCSR *g = (GrafoCSR *) malloc(sizeof(GrafoCSR));
+
+    if (!g)
+        return NULL;
+
+    g->qtd_vertices = qtd_vertices;
+    g->qtd_arcos = qtd_arcos;
+    g->eh_dirigido = eh_dirigido;
+    g->mapeamento = NULL;
+    g->tamanho_mapeamento = 0;
+    g->inicio = (int *) calloc(qtd_vertices + 1, sizeof(int));
+    g->vizinhos = (int *) malloc((qtd_arcos > 0 ? qtd_arcos : 1) * sizeof(int));
+    g->pesos = ponderado ? (float *) malloc((qtd_arcos > 0 ? qtd_arcos : 1) * sizeof(float)) : NULL;
+
+    if (!g->inicio || !g->vizinhos || (ponderado && !g->pesos)) {
+        desalocar_grafo_csr(g);
+        return NULL;
+    }
+    return g;
+}
+
+// Arranjos que apontam para dentro do arquivo mapeado são liberados junto com o mapeamento
+static void liberar_arranjo(const GrafoCSR *g, void *arranjo) {
+    const char *p = (const char *) arranjo, *mapa = (const char *) g->mapeamento;
+
+    if (!mapa || p < mapa || p >= mapa + g->tamanho_mapeamento)
+        free(arranjo);
+}
+
+void desalocar_grafo_csr(GrafoCSR *g) {
+    if (g) {
+        liberar_arranjo(g, g->inicio);
+        liberar_arranjo(g, g->vizinhos);
+        liberar_arranjo(g, g->pesos);
+        if (g->mapeamento)
+            munmap(g->mapeamento, g->tamanho_mapeamento);
+        free(g);
+    }
+}
+
+GrafoCSR *copiar_grafo_csr(const GrafoCSR *g) {
+    GrafoCSR *c = alocar_grafo_csr(g->qtd_vertices, g->qtd_arcos, g->eh_dirigido, g->pesos != NULL);
+
+    if (c) {
+        memcpy(c->inicio, g->inicio, (g->qtd_vertices + 1) * sizeof(int));
+        memcpy(c->vizinhos, g->vizinhos, (size_t) g->qtd_arcos * sizeof(int));
+        if (g->pesos)
+            memcpy(c->pesos, g->pesos, (size_t) g->qtd_arcos * sizeof(float));
+    }
+    return c;
+}
+
+// Uma passada estável de counting sort pelo dígito de BITS_DIGITO bits de u (campo_u) ou de v
+static void ordenar_por_digito(const Aresta *origem, Aresta *destino, int qtd, int campo_u, int deslocamento) {
+    int contagem[TAM_DIGITO + 1] = {0};
+
+    for (int i = 0; i < qtd; i++) {
+        unsigned chave = (unsigned) (campo_u ? origem[i].u : origem[i].v);
+        contagem[((chave >> deslocamento) & (TAM_DIGITO - 1)) + 1]++;
+    }
+    for (int d = 0; d < TAM_DIGITO; d++)
+        contagem[d + 1] += contagem[d];
+
+    for (int i = 0; i < qtd; i++) {
+        unsigned chave = (unsigned) (campo_u ? origem[i].u : origem[i].v);
+        destino[contagem[(chave >> deslocamento) & (TAM_DIGITO - 1)]++] = origem[i];
+    }
+}
+
+/*
+ * Radix sort LSD dos arcos pela chave (u, v): primeiro os dígitos de v, depois os de u.
+ * Como cada passada é estável, arcos repetidos ficam vizinhos e na ordem em que foram lidos.
+ * Retorna o arranjo que contém o resultado (arcos ou aux).
+ */
+static Aresta *ordenar_arcos(Aresta *arcos, Aresta *aux, int qtd, int qtd_vertices) {
+    int bits = 0;
+
+    while (bits < 31 && (1u << bits) < (unsigned) qtd_vertices)
+        bits++;
+
+    for (int campo_u = 0; campo_u <= 1; campo_u++) {
+        for (int deslocamento = 0; deslocamento < bits; deslocamento += BITS_DIGITO) {
+            ordenar_por_digito(arcos, aux, qtd, campo_u, deslocamento);
+
+            Aresta *temp = arcos;
+            arcos = aux;
+            aux = temp;
+        }
+    }
+    return arcos;
+}
+
+GrafoCSR *criar_grafo_csr(const ListaArestas *l) {
+    int n = l->qtd_vertices;
+    long total = 0;
+
+    // Cada aresta não dirigida (que não seja laço) vira dois arcos
+    for (int i = 0; i < l->qtd; i++)
+        total += (!l->eh_dirigido && l->arestas[i].u != l->arestas[i].v) ? 2 : 1;
+
+    if (total > INT_MAX)
+        return NULL;
+
+    Aresta *arcos = (Aresta *) malloc((total > 0 ? total : 1) * sizeof(Aresta));
+    Aresta *aux = (Aresta *) malloc((total > 0 ? total : 1) * sizeof(Aresta));
+
+    if (!arcos || !aux) {
+        free(arcos);
+        free(aux);
+        return NULL;
+    }
+
+    int qtd = 0;
+    for (int i = 0; i < l->qtd; i++) {
+        const Aresta *a = &l->arestas[i];
+
+        arcos[qtd++] = *a;
+        if (!l->eh_dirigido && a->u != a->v) {
+            arcos[qtd].u = a->v;
+            arcos[qtd].v = a->u;
+            arcos[qtd].peso = a->peso;
+            qtd++;
+        }
+    }
+
+    Aresta *ordenados = ordenar_arcos(arcos, aux, qtd, n);
+
+    // Remove as repetições: vale a primeira ocorrência de (u,v) na entrada
+    int unicos = 0;
+    for (int i = 0; i < qtd; i++)
+        if (i == 0 || ordenados[i].u != ordenados[i - 1].u || ordenados[i].v != ordenados[i - 1].v)
+            ordenados[unicos++] = ordenados[i];
+
+    GrafoCSR *g = alocar_grafo_csr(n, unicos, l->eh_dirigido, l->ponderado);
+
+    if (g) {
+        for (int i = 0; i < unicos; i++) {
+            g->inicio[ordenados[i].u + 1]++;
+            g->vizinhos[i] = ordenados[i].v;
+            if (g->pesos)
+                g->pesos[i] = ordenados[i].peso;
+        }
+        for (int u = 0; u < n; u++)
+            g->inicio[u + 1] += g->inicio[u];
+    }
+
+    free(arcos);
+    free(aux);
+    return g;
+}
+
+GrafoCSR *transpor_grafo_csr(const GrafoCSR *g) {
+    int n = g->qtd_vertices;
+    GrafoCSR *t = alocar_grafo_csr(n, g->qtd_arcos, 1, g->pesos != NULL);
+    int *livre = (int *) malloc((n > 0 ? n : 1) * sizeof(int));
+
+    if (!t || !livre) {
+        desalocar_grafo_csr(t);
+        free(livre);
+        return NULL;
+    }
+
+    for (int i = 0; i < g->qtd_arcos; i++)
+        t->inicio[g->vizinhos[i] + 1]++;
+    for (int u = 0; u < n; u++)
+        t->inicio[u + 1] += t->inicio[u];
+
+    memcpy(livre, t->inicio, n * sizeof(int));
+
+    // Percorrer u em ordem crescente mantém cada linha do transposto ordenada pela origem
+    for (int u = 0; u < n; u++) {
+        for (int i = g->inicio[u]; i < g->inicio[u + 1]; i++) {
+            int v = g->vizinhos[i];
+
+            t->vizinhos[livre[v]] = u;
+            if (t->pesos)
+                t->pesos[livre[v]] = g->pesos[i];
+            livre[v]++;
+        }
+    }
+
+    free(livre);
+    return t;
+}
+
+bool possui_peso_negativo(const GrafoCSR *g) {
+    if (g->pesos)
+        for (int i = 0; i < g->qtd_arcos; i++)
+            if (g->pesos[i] < 0)
+                return true;
+    return false;
+}
+
+int posicao_arco_csr(const GrafoCSR *g, int u, int v) {
+    // As linhas estão ordenadas pelo vértice de destino, então basta uma busca binária
+    int esq = g->inicio[u], dir = g->inicio[u + 1] - 1;
+
+    while (esq <= dir) {
+        int meio = esq + (dir - esq) / 2;
+
+        if (g->vizinhos[meio] == v)
+            return meio;
+        if (g->vizinhos[meio] < v)
+            esq = meio + 1;
+        else
+            dir = meio - 1;
+    }
+    return -1;
+}
+
+
+// Finalização do splitmix64: espalha cada bit da entrada por toda a saída
+static uint64_t misturar(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+uint64_t soma_verificacao_csr(const GrafoCSR *g) {
+    // Cada posição entra misturada com o seu índice e o arranjo de onde vem, então a soma
+    // (que pode ser dividida entre threads) muda se qualquer valor mudar ou trocar de lugar
+    uint64_t soma = misturar((uint64_t) g->qtd_vertices << 32 | (uint32_t) g->qtd_arcos);
+
+    #pragma omp parallel for schedule(static) reduction(+: soma)
+    for (int u = 0; u <= g->qtd_vertices; u++)
+        soma += misturar(((uint64_t) u << 32 | (uint32_t) g->inicio[u]) ^ 0x1111111111111111ull);
+
+    #pragma omp parallel for schedule(static) reduction(+: soma)
+    for (int e = 0; e < g->qtd_arcos; e++) {
+        uint32_t peso = 0;
+
+        if (g->pesos)
+            memcpy(&peso, &g->pesos[e], sizeof(peso));
+        soma += misturar(((uint64_t) e << 32 | (uint32_t) g->vizinhos[e]) ^ 0x2222222222222222ull)
+              + misturar(((uint64_t) e << 32 | peso) ^ 0x3333333333333333ull);
+    }
+    return soma;
+}
@@ -0,0 +1,72 @@
+#ifndef GRAFO_CSR_H
+#define GRAFO_CSR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Representação compartilhada de grafos em formato CSR (compressed sparse row).
+ *
+ * Em vez de um nó alocado por aresta, as listas de adjacência ficam contíguas:
+ * os vizinhos de u estão em vizinhos[inicio[u]] ... vizinhos[inicio[u + 1] - 1],
+ * e o peso de cada arco fica na mesma posição do arranjo pesos.
+ *
+ * O grafo é montado de uma vez a partir de uma lista de arestas (ListaArestas),
+ * que é o que os programas preenchem ao ler a entrada. A montagem ordena os arcos
+ * por (u, v) com radix sort, então cada linha fica em ordem crescente de vizinho.
+ */
+
+typedef struct Aresta Aresta;
+typedef struct ListaArestas ListaArestas;
+typedef struct GrafoCSR GrafoCSR;
+
+struct Aresta {
+    int u, v;
+    float peso;
+};
+
+struct ListaArestas {
+    int qtd_vertices;
+    int eh_dirigido;
+    bool ponderado;     // false quando a entrada não tem a coluna de pesos
+    int qtd;           // quantidade de arestas lidas
+    int capacidade;   // tamanho alocado do arranjo de arestas
+    Aresta *arestas;
+};
+
+struct GrafoCSR {
+    int qtd_vertices;
+    int qtd_arcos;        // arcos armazenados (arestas não dirigidas contam duas vezes)
+    int eh_dirigido;
+    int *inicio;         // qtd_vertices + 1 deslocamentos
+    int *vizinhos;      // qtd_arcos vértices de destino
+    float *pesos;      // qtd_arcos pesos, ou NULL para grafos não ponderados
+    void *mapeamento;          // arquivo binário mapeado de onde vêm os arranjos, ou NULL
+    size_t tamanho_mapeamento;
+};
+
+#define grau_saida(g, u) ((g)->inicio[(u) + 1] - (g)->inicio[(u)])
+
+ListaArestas *criar_lista_arestas(int qtd_vertices, int eh_dirigido, bool ponderado);
+void desalocar_lista_arestas(ListaArestas *l);
+// Retorna 0 se a aresta tiver extremidades fora do intervalo [0, qtd_vertices) ou faltar memória
+int adicionar_aresta(ListaArestas *l, int u, int v, float peso);
+
+// Monta o grafo ordenando as arestas (radix sort), sem arestas paralelas e espelhando as não dirigidas
+GrafoCSR *criar_grafo_csr(const ListaArestas *l);
+// Cópia com arranjos próprios (útil para alterar um grafo carregado de um arquivo mapeado)
+GrafoCSR *copiar_grafo_csr(const GrafoCSR *g);
+// Grafo com todos os arcos invertidos (sempre dirigido)
+GrafoCSR *transpor_grafo_csr(const GrafoCSR *g);
+void desalocar_grafo_csr(GrafoCSR *g);
+
+bool possui_peso_negativo(const GrafoCSR *g);
+
+// Posição do arco (u, v) em vizinhos e pesos, ou -1 se ele não existir: busca binária na linha de u, O(log grau(u))
+int posicao_arco_csr(const GrafoCSR *g, int u, int v);
+
+// Soma de verificação de inicio, vizinhos e pesos, para reconhecer o grafo de onde saiu um arquivo derivado dele
+uint64_t soma_verificacao_csr(const GrafoCSR *g);
+
+#endif
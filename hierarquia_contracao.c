@@ -0,0 +1,729 @@
+#include <stdio.h>
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hierarquia_contracao.h"
+#include "fila_prioridade.h"
+#include "cronometro.h"
+
+#define ALINHAMENTO_HIERARQUIA 64
+
+/*
+ * As buscas de testemunha param depois de processar tantos vértices. Parar cedo só faz
+ * aparecer atalhos que não seriam necessários; a hierarquia continua exata. Na simulação
+ * (que só estima a prioridade) o limite é menor.
+ */
+#define LIMITE_TESTEMUNHA 1000
+#define LIMITE_TESTEMUNHA_SIMULACAO 100
+
+/* --- Grafo restante durante a contração --- */
+
+typedef struct ArcoDinamico {
+    int vizinho;
+    float peso;
+    int meio;
+} ArcoDinamico;
+
+typedef struct ListaArcos {
+    ArcoDinamico *arcos;
+    int tam, capacidade;
+} ListaArcos;
+
+static bool anexar_arco(ListaArcos *l, int vizinho, float peso, int meio) {
+    if (l->tam == l->capacidade) {
+        int nova = l->capacidade ? 2 * l->capacidade : 4;
+        ArcoDinamico *novo = (ArcoDinamico *) realloc(l->arcos, nova * sizeof(ArcoDinamico));
+
+        if (!novo)
+            return false;
+        l->arcos = novo;
+        l->capacidade = nova;
+    }
+    l->arcos[l->tam++] = (ArcoDinamico) { vizinho, peso, meio };
+    return true;
+}
+
+static ArcoDinamico *procurar_arco(ListaArcos *l, int vizinho) {
+    for (int i = 0; i < l->tam; i++)
+        if (l->arcos[i].vizinho == vizinho)
+            return &l->arcos[i];
+    return NULL;
+}
+
+static void remover_arco(ListaArcos *l, int vizinho) {
+    for (int i = 0; i < l->tam; i++) {
+        if (l->arcos[i].vizinho == vizinho) {
+            l->arcos[i] = l->arcos[--l->tam];  // a ordem das listas dinâmicas não importa
+            return;
+        }
+    }
+}
+
+typedef struct Contracao {
+    int qtd_vertices;
+    ListaArcos *saida, *entrada;   // arcos entre vértices ainda não contraídos (depois, os da hierarquia)
+    int *vizinhos_contraidos;
+    int *profundidade;            // 1 + maior profundidade de um vizinho contraído antes
+
+    // Busca de testemunha: Dijkstra limitado com reinício proporcional ao que foi tocado
+    FilaPrioridade *Q;
+    float *d;
+    int *tocados, qtd_tocados;
+
+    int *marca;     // marca[v] == v0 se v já foi visto entre os vizinhos de v0
+    int *alvo;     // alvo[x] == v se x é vizinho de saída do vértice v em contração
+    long qtd_atalhos;
+} Contracao;
+
+// Para ao passar do limite de distância, ao processar todos os qtd_alvos vizinhos de saída de ignorado ou ao chegar a max_processados
+static void busca_testemunha(Contracao *C, int origem, int ignorado, float limite, int qtd_alvos, int max_processados) {
+    for (int i = 0; i < C->qtd_tocados; i++)
+        C->d[C->tocados[i]] = FLT_MAX;
+    C->qtd_tocados = 0;
+    esvaziar_fila(C->Q);
+
+    C->d[origem] = 0;
+    C->tocados[C->qtd_tocados++] = origem;
+    diminuir_chave(C->Q, origem, 0);
+
+    int u, processados = 0;
+    float d_u;
+    while (processados < max_processados && (u = extrair_minimo(C->Q, &d_u)) != -1) {
+        if (d_u > limite)
+            break;
+        processados++;
+
+        if (C->alvo[u] == ignorado && u != origem && --qtd_alvos == 0)
+            break;  // todos os vizinhos de saída já têm a distância definitiva
+
+        const ListaArcos *l = &C->saida[u];
+        for (int i = 0; i < l->tam; i++) {
+            int v = l->arcos[i].vizinho;
+            float nova = d_u + l->arcos[i].peso;
+
+            if (v != ignorado && nova < C->d[v]) {
+                if (C->d[v] == FLT_MAX)
+                    C->tocados[C->qtd_tocados++] = v;
+                C->d[v] = nova;
+                diminuir_chave(C->Q, v, nova);
+            }
+        }
+    }
+}
+
+static bool adicionar_atalho(Contracao *C, int u, int x, float peso, int meio) {
+    ArcoDinamico *a = procurar_arco(&C->saida[u], x);
+
+    if (a) {
+        if (peso < a->peso) {
+            ArcoDinamico *b = procurar_arco(&C->entrada[x], u);
+
+            a->peso = b->peso = peso;
+            a->meio = b->meio = meio;
+        }
+        return true;
+    }
+    if (!anexar_arco(&C->saida[u], x, peso, meio) || !anexar_arco(&C->entrada[x], u, peso, meio))
+        return false;
+    C->qtd_atalhos++;
+    return true;
+}
+
+// Conta (simular) ou insere os atalhos necessários para contrair v; retorna -1 se faltar memória
+static int contrair(Contracao *C, int v, bool simular) {
+    const ListaArcos *entrada = &C->entrada[v], *saida = &C->saida[v];
+    int atalhos = 0;
+
+    for (int j = 0; j < saida->tam; j++)
+        C->alvo[saida->arcos[j].vizinho] = v;
+
+    for (int i = 0; i < entrada->tam; i++) {
+        int u = entrada->arcos[i].vizinho, qtd_alvos = 0;
+        float peso_u = entrada->arcos[i].peso, limite = -1;
+
+        for (int j = 0; j < saida->tam; j++) {
+            if (saida->arcos[j].vizinho != u) {
+                qtd_alvos++;
+                if (peso_u + saida->arcos[j].peso > limite)
+                    limite = peso_u + saida->arcos[j].peso;
+            }
+        }
+
+        if (qtd_alvos == 0)
+            continue;  // o único vizinho de saída é o próprio u
+
+        busca_testemunha(C, u, v, limite, qtd_alvos, simular ? LIMITE_TESTEMUNHA_SIMULACAO : LIMITE_TESTEMUNHA);
+
+        for (int j = 0; j < saida->tam; j++) {
+            int x = saida->arcos[j].vizinho;
+            float peso = peso_u + saida->arcos[j].peso;
+
+            if (x != u && C->d[x] > peso) {
+                atalhos++;
+                if (!simular && !adicionar_atalho(C, u, x, peso, v))
+                    return -1;
+            }
+        }
+    }
+    return atalhos;
+}
+
+static float prioridade(Contracao *C, int v) {
+    int diferenca = contrair(C, v, true) - C->entrada[v].tam - C->saida[v].tam;
+
+    return (float) (2 * diferenca + C->vizinhos_contraidos[v] + C->profundidade[v]);
+}
+
+// Tira v do grafo restante; as listas de v ficam como estão e viram os arcos de v na hierarquia
+static void remover_vertice(Contracao *C, int v) {
+    for (int i = 0; i < C->saida[v].tam; i++)
+        remover_arco(&C->entrada[C->saida[v].arcos[i].vizinho], v);
+    for (int i = 0; i < C->entrada[v].tam; i++)
+        remover_arco(&C->saida[C->entrada[v].arcos[i].vizinho], v);
+}
+
+/*
+ * Os termos baratos da prioridade dos vizinhos são atualizados aqui; a diferença de arcos só é
+ * recalculada quando o vértice sai da fila (atualização preguiçosa). Simular de novo todos os
+ * vizinhos a cada contração custaria caro demais em vértices de grau alto.
+ */
+static void atualizar_vizinho(Contracao *C, int v, int x) {
+    if (C->marca[x] == v)
+        return;  // vizinho de entrada e de saída ao mesmo tempo
+    C->marca[x] = v;
+
+    C->vizinhos_contraidos[x]++;
+    if (C->profundidade[x] < C->profundidade[v] + 1)
+        C->profundidade[x] = C->profundidade[v] + 1;
+}
+
+static int comparar_arcos(const void *a, const void *b) {
+    return ((const ArcoDinamico *) a)->vizinho - ((const ArcoDinamico *) b)->vizinho;
+}
+
+// Copia as listas finais para os arranjos da hierarquia, ordenando cada linha por vizinho
+static bool montar_arranjos(ListaArcos *listas, int n, int **inicio, int **vizinhos, float **pesos, int **meio, int *qtd) {
+    long total = 0;
+
+    for (int v = 0; v < n; v++)
+        total += listas[v].tam;
+    if (total > INT_MAX)
+        return false;
+
+    *qtd = (int) total;
+    *inicio = (int *) malloc((n + 1) * sizeof(int));
+    *vizinhos = (int *) malloc((total > 0 ? total : 1) * sizeof(int));
+    *pesos = (float *) malloc((total > 0 ? total : 1) * sizeof(float));
+    *meio = (int *) malloc((total > 0 ? total : 1) * sizeof(int));
+
+    if (!*inicio || !*vizinhos || !*pesos || !*meio)
+        return false;
+
+    int e = 0;
+    for (int v = 0; v < n; v++) {
+        (*inicio)[v] = e;
+        if (listas[v].tam > 1)
+            qsort(listas[v].arcos, listas[v].tam, sizeof(ArcoDinamico), comparar_arcos);
+
+        for (int i = 0; i < listas[v].tam; i++, e++) {
+            (*vizinhos)[e] = listas[v].arcos[i].vizinho;
+            (*pesos)[e] = listas[v].arcos[i].peso;
+            (*meio)[e] = listas[v].arcos[i].meio;
+        }
+    }
+    (*inicio)[n] = e;
+    return true;
+}
+
+HierarquiaContracao *construir_hierarquia(const GrafoCSR *g, bool verboso) {
+    int n = g->qtd_vertices, n_alocado = n > 0 ? n : 1;
+    Contracao C = { .qtd_vertices = n };
+    HierarquiaContracao *H = (HierarquiaContracao *) calloc(1, sizeof(HierarquiaContracao));
+    FilaPrioridade *ordem = criar_fila_prioridade(FILA_BINARIA, n);
+
+    C.saida = (ListaArcos *) calloc(n_alocado, sizeof(ListaArcos));
+    C.entrada = (ListaArcos *) calloc(n_alocado, sizeof(ListaArcos));
+    C.vizinhos_contraidos = (int *) calloc(n_alocado, sizeof(int));
+    C.profundidade = (int *) calloc(n_alocado, sizeof(int));
+    C.Q = criar_fila_prioridade(FILA_BINARIA, n);
+    C.d = (float *) malloc(n_alocado * sizeof(float));
+    C.tocados = (int *) malloc(n_alocado * sizeof(int));
+    C.marca = (int *) malloc(n_alocado * sizeof(int));
+    C.alvo = (int *) malloc(n_alocado * sizeof(int));
+
+    bool ok = H && ordem && C.saida && C.entrada && C.vizinhos_contraidos && C.profundidade
+              && C.Q && C.d && C.tocados && C.marca && C.alvo;
+
+    if (ok) {
+        H->qtd_vertices = n;
+        H->qtd_arcos_grafo = g->qtd_arcos;
+        H->soma_grafo = soma_verificacao_csr(g);
+        H->nivel = (int *) malloc(n_alocado * sizeof(int));
+        ok = H->nivel != NULL;
+    }
+
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            C.d[v] = FLT_MAX;
+            C.marca[v] = C.alvo[v] = -1;
+        }
+
+        for (int u = 0; ok && u < n; u++) {
+            for (int e = g->inicio[u]; ok && e < g->inicio[u + 1]; e++) {
+                int v = g->vizinhos[e];
+
+                if (v != u)  // laços nunca fazem parte de um caminho mínimo
+                    ok = anexar_arco(&C.saida[u], v, g->pesos[e], -1) && anexar_arco(&C.entrada[v], u, g->pesos[e], -1);
+            }
+        }
+    }
+
+    if (ok) {
+        for (int v = 0; v < n; v++)
+            diminuir_chave(ordem, v, prioridade(&C, v));
+
+        double inicio = tempo_atual();
+        int nivel = 0, v;
+        float chave;
+
+        while ((v = extrair_minimo(ordem, &chave)) != -1) {
+            // Atualização preguiçosa: se a prioridade real piorou, v volta para a fila
+            float atual = prioridade(&C, v);
+            if (atual > chave) {
+                diminuir_chave(ordem, v, atual);
+                continue;
+            }
+
+            if (contrair(&C, v, false) < 0) {
+                ok = false;
+                break;
+            }
+            remover_vertice(&C, v);
+            H->nivel[v] = nivel++;
+
+            for (int i = 0; i < C.saida[v].tam; i++)
+                atualizar_vizinho(&C, v, C.saida[v].arcos[i].vizinho);
+            for (int i = 0; i < C.entrada[v].tam; i++)
+                atualizar_vizinho(&C, v, C.entrada[v].arcos[i].vizinho);
+
+            if (verboso && nivel % 100000 == 0)
+                fprintf(stderr, "%d de %d vértices contraídos, %ld atalhos (%.1f s)\n", nivel, n, C.qtd_atalhos,
+                        tempo_atual() - inicio);
+        }
+
+        ok = ok && montar_arranjos(C.saida, n, &H->inicio_subida, &H->vizinhos_subida, &H->pesos_subida,
+                             &H->meio_subida, &H->qtd_arcos_subida)
+             && montar_arranjos(C.entrada, n, &H->inicio_descida, &H->vizinhos_descida, &H->pesos_descida,
+                                &H->meio_descida, &H->qtd_arcos_descida);
+    }
+
+    for (int v = 0; C.saida && C.entrada && v < n; v++) {
+        free(C.saida[v].arcos);
+        free(C.entrada[v].arcos);
+    }
+    free(C.saida);
+    free(C.entrada);
+    free(C.vizinhos_contraidos);
+    free(C.profundidade);
+    desalocar_fila_prioridade(C.Q);
+    free(C.d);
+    free(C.tocados);
+    free(C.marca);
+    free(C.alvo);
+    desalocar_fila_prioridade(ordem);
+
+    if (!ok) {
+        desalocar_hierarquia(H);
+        return NULL;
+    }
+    return H;
+}
+
+// Arranjos de H na ordem do enum ARRANJO_*, com os seus tamanhos em bytes
+static void listar_arranjos(const HierarquiaContracao *H, void *arranjos[], size_t tamanhos[]) {
+    size_t n = H->qtd_vertices, s = H->qtd_arcos_subida, d = H->qtd_arcos_descida;
+
+    arranjos[ARRANJO_NIVEL] = H->nivel;                       tamanhos[ARRANJO_NIVEL] = n * sizeof(int);
+    arranjos[ARRANJO_INICIO_SUBIDA] = H->inicio_subida;       tamanhos[ARRANJO_INICIO_SUBIDA] = (n + 1) * sizeof(int);
+    arranjos[ARRANJO_VIZINHOS_SUBIDA] = H->vizinhos_subida;   tamanhos[ARRANJO_VIZINHOS_SUBIDA] = s * sizeof(int);
+    arranjos[ARRANJO_PESOS_SUBIDA] = H->pesos_subida;         tamanhos[ARRANJO_PESOS_SUBIDA] = s * sizeof(float);
+    arranjos[ARRANJO_MEIO_SUBIDA] = H->meio_subida;           tamanhos[ARRANJO_MEIO_SUBIDA] = s * sizeof(int);
+    arranjos[ARRANJO_INICIO_DESCIDA] = H->inicio_descida;     tamanhos[ARRANJO_INICIO_DESCIDA] = (n + 1) * sizeof(int);
+    arranjos[ARRANJO_VIZINHOS_DESCIDA] = H->vizinhos_descida; tamanhos[ARRANJO_VIZINHOS_DESCIDA] = d * sizeof(int);
+    arranjos[ARRANJO_PESOS_DESCIDA] = H->pesos_descida;       tamanhos[ARRANJO_PESOS_DESCIDA] = d * sizeof(float);
+    arranjos[ARRANJO_MEIO_DESCIDA] = H->meio_descida;         tamanhos[ARRANJO_MEIO_DESCIDA] = d * sizeof(int);
+}
+
+void desalocar_hierarquia(HierarquiaContracao *H) {
+    if (H) {
+        if (H->mapeamento)
+            munmap(H->mapeamento, H->tamanho_mapeamento);
+        else {
+            void *arranjos[QTD_ARRANJOS_HIERARQUIA];
+            size_t tamanhos[QTD_ARRANJOS_HIERARQUIA];
+
+            listar_arranjos(H, arranjos, tamanhos);
+            for (int i = 0; i < QTD_ARRANJOS_HIERARQUIA; i++)
+                free(arranjos[i]);
+        }
+        free(H);
+    }
+}
+
+static size_t alinhar(size_t deslocamento) {
+    return (deslocamento + ALINHAMENTO_HIERARQUIA - 1) & ~(size_t) (ALINHAMENTO_HIERARQUIA - 1);
+}
+
+int gravar_hierarquia(const HierarquiaContracao *H, FILE *saida) {
+    CabecalhoHierarquia cab;
+    void *arranjos[QTD_ARRANJOS_HIERARQUIA];
+    size_t tamanhos[QTD_ARRANJOS_HIERARQUIA];
+
+    listar_arranjos(H, arranjos, tamanhos);
+
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magica, MAGICA_HIERARQUIA, 8);
+    cab.versao = VERSAO_HIERARQUIA;
+    cab.qtd_vertices = H->qtd_vertices;
+    cab.qtd_arcos_subida = H->qtd_arcos_subida;
+    cab.qtd_arcos_descida = H->qtd_arcos_descida;
+    cab.qtd_arcos_grafo = H->qtd_arcos_grafo;
+    cab.soma_grafo = H->soma_grafo;
+
+    size_t fim = sizeof(cab);
+    for (int i = 0; i < QTD_ARRANJOS_HIERARQUIA; i++) {
+        cab.desloc[i] = alinhar(fim);
+        fim = cab.desloc[i] + tamanhos[i];
+    }
+
+    size_t escrito = fwrite(&cab, 1, sizeof(cab), saida);
+
+    for (int i = 0; i < QTD_ARRANJOS_HIERARQUIA; i++) {
+        while (escrito < cab.desloc[i] && fputc(0, saida) != EOF)
+            escrito++;
+        escrito += fwrite(arranjos[i], 1, tamanhos[i], saida);
+    }
+    return escrito == fim && !ferror(saida);
+}
+
+/*
+ * Confere um dos dois lados: inicio começa em 0, não diminui e termina em qtd_arcos; cada linha
+ * é estritamente crescente, com vizinhos em [0, n), como a busca binária de posicao_arco
+ * exige; meio está em [-1, n); e os pesos não são negativos nem NaN.
+ */
+static bool lado_valido(int n, int qtd_arcos, const int *inicio, const int *vizinhos, const int *meio, const float *pesos) {
+    bool ok = inicio[0] == 0 && inicio[n] == qtd_arcos;
+
+    #pragma omp parallel for schedule(static) reduction(&&: ok)
+    for (int u = 0; u < n; u++)
+        ok = ok && inicio[u] <= inicio[u + 1];
+
+    if (!ok)
+        return false;
+
+    #pragma omp parallel for schedule(static) reduction(&&: ok)
+    for (int u = 0; u < n; u++)
+        for (int e = inicio[u]; ok && e < inicio[u + 1]; e++)
+            ok = (unsigned) vizinhos[e] < (unsigned) n && (e == inicio[u] || vizinhos[e - 1] < vizinhos[e])
+                 && meio[e] >= -1 && meio[e] < n && pesos[e] >= 0;
+
+    return ok;
+}
+
+HierarquiaContracao *carregar_hierarquia(int fd) {
+    struct stat info;
+
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || (size_t) info.st_size < sizeof(CabecalhoHierarquia))
+        return NULL;
+
+    char *dados = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (dados == MAP_FAILED)
+        return NULL;
+
+    const CabecalhoHierarquia *cab = (const CabecalhoHierarquia *) dados;
+    HierarquiaContracao *H = NULL;
+
+    if (memcmp(cab->magica, MAGICA_HIERARQUIA, 8) == 0 && cab->versao == VERSAO_HIERARQUIA
+        && cab->qtd_vertices < INT_MAX && cab->qtd_arcos_subida <= INT_MAX && cab->qtd_arcos_descida <= INT_MAX)
+        H = (HierarquiaContracao *) calloc(1, sizeof(HierarquiaContracao));
+
+    if (!H) {
+        munmap(dados, info.st_size);
+        return NULL;
+    }
+
+    H->qtd_vertices = (int) cab->qtd_vertices;
+    H->qtd_arcos_subida = (int) cab->qtd_arcos_subida;
+    H->qtd_arcos_descida = (int) cab->qtd_arcos_descida;
+    H->qtd_arcos_grafo = (int) cab->qtd_arcos_grafo;
+    H->soma_grafo = cab->soma_grafo;
+    H->mapeamento = dados;
+    H->tamanho_mapeamento = info.st_size;
+
+    void *arranjos[QTD_ARRANJOS_HIERARQUIA];
+    size_t tamanhos[QTD_ARRANJOS_HIERARQUIA];
+    listar_arranjos(H, arranjos, tamanhos);  // só os tamanhos interessam aqui
+
+    // Confere se cada arranjo está alinhado e cabe no arquivo, antes de percorrer o conteúdo.
+    // A soma desloc + tamanho poderia dar a volta, por isso a comparação é com o que sobra.
+    for (int i = 0; i < QTD_ARRANJOS_HIERARQUIA; i++) {
+        if (cab->desloc[i] % ALINHAMENTO_HIERARQUIA != 0 || cab->desloc[i] > (size_t) info.st_size
+            || tamanhos[i] > (size_t) info.st_size - cab->desloc[i]) {
+            desalocar_hierarquia(H);
+            return NULL;
+        }
+    }
+
+    H->nivel = (int *) (dados + cab->desloc[ARRANJO_NIVEL]);
+    H->inicio_subida = (int *) (dados + cab->desloc[ARRANJO_INICIO_SUBIDA]);
+    H->vizinhos_subida = (int *) (dados + cab->desloc[ARRANJO_VIZINHOS_SUBIDA]);
+    H->pesos_subida = (float *) (dados + cab->desloc[ARRANJO_PESOS_SUBIDA]);
+    H->meio_subida = (int *) (dados + cab->desloc[ARRANJO_MEIO_SUBIDA]);
+    H->inicio_descida = (int *) (dados + cab->desloc[ARRANJO_INICIO_DESCIDA]);
+    H->vizinhos_descida = (int *) (dados + cab->desloc[ARRANJO_VIZINHOS_DESCIDA]);
+    H->pesos_descida = (float *) (dados + cab->desloc[ARRANJO_PESOS_DESCIDA]);
+    H->meio_descida = (int *) (dados + cab->desloc[ARRANJO_MEIO_DESCIDA]);
+
+    if (cab->qtd_arcos_grafo > INT_MAX
+        || !lado_valido(H->qtd_vertices, H->qtd_arcos_subida, H->inicio_subida, H->vizinhos_subida, H->meio_subida, H->pesos_subida)
+        || !lado_valido(H->qtd_vertices, H->qtd_arcos_descida, H->inicio_descida, H->vizinhos_descida, H->meio_descida, H->pesos_descida)) {
+        desalocar_hierarquia(H);
+        return NULL;
+    }
+    return H;
+}
+
+/* --- Consultas --- */
+
+enum { IDA, VOLTA };
+
+struct ConsultaHierarquia {
+    const HierarquiaContracao *H;
+    FilaPrioridade *Q[2];
+    float *d[2];
+    int *pai[2];         // vértice anterior na busca de cada lado (na volta, o seguinte rumo a t)
+    int *tocados;       // vértices com d < FLT_MAX em algum dos lados (podem se repetir)
+    int qtd_tocados;
+    int *cadeia;       // metade de ida do caminho na hierarquia, do encontro até s
+    int *pilha;       // pares (a, b) de arcos ainda por desempacotar
+};
+
+ConsultaHierarquia *criar_consulta_hierarquia(const HierarquiaContracao *H) {
+    int n = H->qtd_vertices > 0 ? H->qtd_vertices : 1;
+    ConsultaHierarquia *C = (ConsultaHierarquia *) calloc(1, sizeof(ConsultaHierarquia));
+
+    if (!C)
+        return NULL;
+
+    C->H = H;
+    bool ok = true;
+    for (int lado = IDA; lado <= VOLTA; lado++) {
+        C->Q[lado] = criar_fila_prioridade(FILA_BINARIA, H->qtd_vertices);
+        C->d[lado] = (float *) malloc(n * sizeof(float));
+        C->pai[lado] = (int *) malloc(n * sizeof(int));
+        ok = ok && C->Q[lado] && C->d[lado] && C->pai[lado];
+    }
+    C->tocados = (int *) malloc(2 * (size_t) n * sizeof(int));
+    C->cadeia = (int *) malloc(n * sizeof(int));
+    C->pilha = (int *) malloc(2 * ((size_t) n + 1) * sizeof(int));
+
+    if (!ok || !C->tocados || !C->cadeia || !C->pilha) {
+        desalocar_consulta_hierarquia(C);
+        return NULL;
+    }
+
+    for (int v = 0; v < H->qtd_vertices; v++) {
+        C->d[IDA][v] = C->d[VOLTA][v] = FLT_MAX;
+        C->pai[IDA][v] = C->pai[VOLTA][v] = -1;
+    }
+    return C;
+}
+
+void desalocar_consulta_hierarquia(ConsultaHierarquia *C) {
+    if (C) {
+        for (int lado = IDA; lado <= VOLTA; lado++) {
+            desalocar_fila_prioridade(C->Q[lado]);
+            free(C->d[lado]);
+            free(C->pai[lado]);
+        }
+        free(C->tocados);
+        free(C->cadeia);
+        free(C->pilha);
+        free(C);
+    }
+}
+
+static void restaurar_consulta(ConsultaHierarquia *C) {
+    for (int i = 0; i < C->qtd_tocados; i++) {
+        int v = C->tocados[i];
+
+        C->d[IDA][v] = C->d[VOLTA][v] = FLT_MAX;
+        C->pai[IDA][v] = C->pai[VOLTA][v] = -1;
+    }
+    C->qtd_tocados = 0;
+    esvaziar_fila(C->Q[IDA]);
+    esvaziar_fila(C->Q[VOLTA]);
+}
+
+/*
+ * Um vértice u pode ser "parado" (stall-on-demand): se algum arco que desce até u a partir
+ * de um vértice já alcançado pelo mesmo lado dá a u uma distância menor que a da fila, u não
+ * está num caminho mínimo e os seus arcos não precisam ser relaxados.
+ */
+static bool parado(const ConsultaHierarquia *C, int lado, int u, float d_u) {
+    const HierarquiaContracao *H = C->H;
+    const int *inicio = lado == IDA ? H->inicio_descida : H->inicio_subida;
+    const int *vizinhos = lado == IDA ? H->vizinhos_descida : H->vizinhos_subida;
+    const float *pesos = lado == IDA ? H->pesos_descida : H->pesos_subida;
+    const float *d = C->d[lado];
+
+    for (int e = inicio[u]; e < inicio[u + 1]; e++)
+        if (d[vizinhos[e]] < FLT_MAX && d[vizinhos[e]] + pesos[e] < d_u)
+            return true;
+    return false;
+}
+
+// Posição do arco a -> b na linha da hierarquia que o guarda (busca binária)
+static int posicao_arco(const HierarquiaContracao *H, int a, int b, bool *subida) {
+    const int *vizinhos;
+    int esq, dir, procurado;
+
+    *subida = H->nivel[a] < H->nivel[b];
+    if (*subida) {
+        vizinhos = H->vizinhos_subida;
+        esq = H->inicio_subida[a];
+        dir = H->inicio_subida[a + 1] - 1;
+        procurado = b;
+    } else {
+        vizinhos = H->vizinhos_descida;
+        esq = H->inicio_descida[b];
+        dir = H->inicio_descida[b + 1] - 1;
+        procurado = a;
+    }
+
+    while (esq <= dir) {
+        int meio = esq + (dir - esq) / 2;
+
+        if (vizinhos[meio] == procurado)
+            return meio;
+        if (vizinhos[meio] < procurado)
+            esq = meio + 1;
+        else
+            dir = meio - 1;
+    }
+    return -1;
+}
+
+// Acrescenta ao caminho os vértices do arco a -> b depois de a, trocando cada atalho pelos dois arcos que ele pula
+static void desempacotar(ConsultaHierarquia *C, int a, int b, int *caminho, float *dist, int *tam) {
+    const HierarquiaContracao *H = C->H;
+    int topo = 0;
+
+    C->pilha[topo++] = a;
+    C->pilha[topo++] = b;
+
+    while (topo > 0) {
+        int y = C->pilha[--topo], x = C->pilha[--topo];
+        bool subida;
+        int e = posicao_arco(H, x, y, &subida);
+        int meio = subida ? H->meio_subida[e] : H->meio_descida[e];
+
+        if (meio == -1) {
+            float peso = subida ? H->pesos_subida[e] : H->pesos_descida[e];
+
+            if (dist)
+                dist[*tam] = dist[*tam - 1] + peso;
+            caminho[(*tam)++] = y;
+        } else {
+            // x -> meio sai primeiro, então vai para o topo da pilha
+            C->pilha[topo++] = meio;
+            C->pilha[topo++] = y;
+            C->pilha[topo++] = x;
+            C->pilha[topo++] = meio;
+        }
+    }
+}
+
+float consultar_hierarquia(ConsultaHierarquia *C, int s, int t, int *caminho, float *dist, int *tam_caminho) {
+    const HierarquiaContracao *H = C->H;
+    float mi = FLT_MAX;
+    int encontro = -1;
+
+    restaurar_consulta(C);
+
+    C->d[IDA][s] = 0;
+    C->d[VOLTA][t] = 0;
+    C->tocados[C->qtd_tocados++] = s;
+    C->tocados[C->qtd_tocados++] = t;
+    diminuir_chave(C->Q[IDA], s, 0);
+    diminuir_chave(C->Q[VOLTA], t, 0);
+
+    bool ativo[2] = { true, true };
+    for (int lado = IDA; ativo[IDA] || ativo[VOLTA]; lado = !lado) {
+        if (!ativo[lado])
+            continue;
+
+        float d_u;
+        int u = extrair_minimo(C->Q[lado], &d_u);
+
+        // Um lado termina quando o menor da fila já não melhora o melhor caminho
+        if (u == -1 || d_u >= mi) {
+            ativo[lado] = false;
+            continue;
+        }
+
+        float outro = C->d[!lado][u];
+        if (outro < FLT_MAX && d_u + outro < mi) {
+            mi = d_u + outro;
+            encontro = u;
+        }
+
+        if (parado(C, lado, u, d_u))
+            continue;
+
+        const int *inicio = lado == IDA ? H->inicio_subida : H->inicio_descida;
+        const int *vizinhos = lado == IDA ? H->vizinhos_subida : H->vizinhos_descida;
+        const float *pesos = lado == IDA ? H->pesos_subida : H->pesos_descida;
+        float *d = C->d[lado];
+
+        for (int e = inicio[u]; e < inicio[u + 1]; e++) {
+            int v = vizinhos[e];
+            float nova = d_u + pesos[e];
+
+            if (nova < d[v]) {
+                if (d[v] == FLT_MAX)
+                    C->tocados[C->qtd_tocados++] = v;
+                d[v] = nova;
+                C->pai[lado][v] = u;
+                diminuir_chave(C->Q[lado], v, nova);
+            }
+        }
+    }
+
+    if (caminho) {
+        *tam_caminho = 0;
+
+        if (encontro != -1) {
+            // Metade de ida: do encontro até s pelos pais, percorrida depois ao contrário
+            int tam_cadeia = 0;
+            for (int v = encontro; v != -1; v = C->pai[IDA][v])
+                C->cadeia[tam_cadeia++] = v;
+
+            caminho[(*tam_caminho)++] = s;
+            if (dist)
+                dist[0] = 0;
+            for (int i = tam_cadeia - 1; i > 0; i--)
+                desempacotar(C, C->cadeia[i], C->cadeia[i - 1], caminho, dist, tam_caminho);
+
+            // Metade de volta: do encontro até t, já na ordem do caminho
+            for (int v = encontro; v != t; v = C->pai[VOLTA][v])
+                desempacotar(C, v, C->pai[VOLTA][v], caminho, dist, tam_caminho);
+        }
+    }
+    return mi;
+}
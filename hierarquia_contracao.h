@@ -0,0 +1,105 @@
+#ifndef HIERARQUIA_CONTRACAO_H
+#define HIERARQUIA_CONTRACAO_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "grafo_csr.h"
+
+/*
+ * Hierarquias de contração (Geisberger, Sanders, Schultes e Delling) para consultas s -> t
+ * repetidas num grafo estático de pesos não negativos.
+ *
+ * No pré-processamento os vértices são contraídos um a um, na ordem de uma fila de
+ * prioridade (diferença de arcos, vizinhos já contraídos e profundidade). Contrair v tira v
+ * do grafo e, para cada par de arcos u -> v -> x, insere o atalho u -> x com o peso dos
+ * dois, a menos que uma busca de testemunha encontre um caminho u ~> x sem v que não seja
+ * mais longo. O nível de um vértice é a sua posição nessa ordem.
+ *
+ * Uma consulta é um Dijkstra bidirecional que só sobe de nível: a busca a partir de s usa os
+ * arcos de subida e a busca a partir de t os de descida, percorridos ao contrário. Cada atalho
+ * guarda o vértice que ele pula (meio), e o caminho é desempacotado até os arcos originais.
+ */
+
+typedef struct HierarquiaContracao HierarquiaContracao;
+typedef struct ConsultaHierarquia ConsultaHierarquia;
+
+struct HierarquiaContracao {
+    int qtd_vertices;
+    int qtd_arcos_subida, qtd_arcos_descida;
+    int *nivel;      // posição de cada vértice na ordem de contração
+
+    // Subida: arcos u -> v com nivel[v] > nivel[u], na linha de u
+    int *inicio_subida, *vizinhos_subida, *meio_subida;
+    float *pesos_subida;
+
+    // Descida: arcos u -> v com nivel[u] > nivel[v], na linha de v (o vizinho guardado é u)
+    int *inicio_descida, *vizinhos_descida, *meio_descida;
+    float *pesos_descida;
+
+    // Nas duas: meio = vértice que o atalho pula, ou -1 num arco do grafo original.
+    // As linhas estão em ordem crescente de vizinho.
+
+    // Grafo de onde a hierarquia saiu, para recusá-la com qualquer outro
+    int qtd_arcos_grafo;
+    uint64_t soma_grafo;     // soma_verificacao_csr do grafo
+
+    void *mapeamento;          // arquivo mapeado de onde vêm os arranjos, ou NULL
+    size_t tamanho_mapeamento;
+};
+
+// Exige pesos não negativos. Com verboso, informa o andamento na saída de erro. Retorna NULL se faltar memória
+HierarquiaContracao *construir_hierarquia(const GrafoCSR *g, bool verboso);
+void desalocar_hierarquia(HierarquiaContracao *H);
+
+/*
+ * Formato em disco (versão 2): cabeçalho de 128 bytes seguido dos arranjos, cada um num
+ * deslocamento múltiplo de 64 bytes, como no formato binário do GrafoCSR. A carga mapeia o
+ * arquivo com mmap, confere o conteúdo dos arranjos numa passada e os usa sem cópia. A
+ * versão 1 não guardava a identificação do grafo.
+ */
+
+#define MAGICA_HIERARQUIA "GRAFOHCH"
+#define VERSAO_HIERARQUIA 2
+
+enum {
+    ARRANJO_NIVEL,
+    ARRANJO_INICIO_SUBIDA, ARRANJO_VIZINHOS_SUBIDA, ARRANJO_PESOS_SUBIDA, ARRANJO_MEIO_SUBIDA,
+    ARRANJO_INICIO_DESCIDA, ARRANJO_VIZINHOS_DESCIDA, ARRANJO_PESOS_DESCIDA, ARRANJO_MEIO_DESCIDA,
+    QTD_ARRANJOS_HIERARQUIA
+};
+
+typedef struct CabecalhoHierarquia {
+    char magica[8];
+    uint32_t versao;
+    uint32_t qtd_arcos_grafo;
+    uint64_t qtd_vertices;
+    uint64_t qtd_arcos_subida;
+    uint64_t qtd_arcos_descida;
+    uint64_t desloc[QTD_ARRANJOS_HIERARQUIA];  // deslocamento em bytes de cada arranjo
+    uint64_t soma_grafo;
+    uint64_t reservado_fim;
+} CabecalhoHierarquia;
+
+// Retorna 0 em caso de erro de escrita
+int gravar_hierarquia(const HierarquiaContracao *H, FILE *saida);
+// fd precisa ser um arquivo regular (a hierarquia é mapeada, não lida). Retorna NULL se o arquivo estiver corrompido
+HierarquiaContracao *carregar_hierarquia(int fd);
+
+/*
+ * Espaço de trabalho das consultas, alocado uma vez: entre consultas só os vértices tocados
+ * pela anterior são restaurados.
+ */
+ConsultaHierarquia *criar_consulta_hierarquia(const HierarquiaContracao *H);
+void desalocar_consulta_hierarquia(ConsultaHierarquia *C);
+
+/*
+ * Distância mínima de s a t, ou FLT_MAX se t não for alcançável. Se caminho != NULL, grava
+ * nele o caminho desempacotado s, ..., t (até qtd_vertices vértices), em *tam_caminho o seu
+ * tamanho e, se dist != NULL, a distância de s a cada vértice do caminho.
+ */
+float consultar_hierarquia(ConsultaHierarquia *C, int s, int t, int *caminho, float *dist, int *tam_caminho);
+
+#endif
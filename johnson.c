@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "grafo_csr.h"
+#include "leitura_grafo.h"
+#include "fila_prioridade.h"
+#include "cronometro.h"
+
+/*
+ * Caminhos mínimos entre todos os pares pelo algoritmo de Johnson, para grafos esparsos com
+ * pesos possivelmente negativos: O(V E log V) de tempo em vez do O(V^3) do Floyd-Warshall, e
+ * sem a matriz V x V inteira na memória.
+ *
+ *   1. Um Bellman-Ford a partir de uma fonte virtual ligada a todos os vértices por arcos de
+ *      peso 0 calcula os potenciais h (h[v] = distância da fonte virtual a v), ou encontra
+ *      um ciclo negativo.
+ *   2. Os arcos são repesados para w'(u, v) = w(u, v) + h[u] - h[v] >= 0, o que preserva os
+ *      caminhos mínimos.
+ *   3. Um Dijkstra por fonte sobre os pesos w', com as fontes divididas entre as threads;
+ *      d(s, v) = d'(s, v) - h[s] + h[v].
+ *
+ * As fontes são processadas em lotes: cada lote produz uma linha de distâncias e uma de
+ * predecessores por fonte, que são exibidas (ou só contabilizadas, com -q) antes do próximo.
+ */
+
+// Com -q as linhas de distâncias não são exibidas (para medir o tempo em grafos grandes)
+static bool verboso = true;
+
+// Fontes por thread em cada lote
+#define FONTES_POR_THREAD 16
+
+/*
+ * Mesmo laço do bellman_ford(), com a fonte virtual implícita: começar com h[v] = 0 para todo v
+ * equivale a já ter relaxado os arcos dela. Para assim que uma passada não muda nada. Em caso de
+ * ciclo negativo, retorna false e guarda em *u_ciclo, *v_ciclo um arco que ainda relaxa, como a
+ * checagem do bellman_ford().
+ */
+bool calcular_potenciais(const GrafoCSR *adj, float *h, int *u_ciclo, int *v_ciclo) {
+    int n = adj->qtd_vertices;
+
+    for (int v = 0; v < n; v++)
+        h[v] = 0;
+
+    for (int i = 0; i < n; i++) {   // n passadas: a fonte virtual conta como mais um vértice
+        bool mudou = false;
+
+        for (int u = 0; u < n; u++) {
+            for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++) {
+                int v = adj->vizinhos[e];
+
+                if (h[v] > h[u] + adj->pesos[e]) {
+                    h[v] = h[u] + adj->pesos[e];
+                    mudou = true;
+                }
+            }
+        }
+        if (!mudou)
+            return true;
+    }
+
+    for (int u = 0; u < n; u++) {
+        for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++) {
+            int v = adj->vizinhos[e];
+
+            if (h[v] > h[u] + adj->pesos[e]) {
+                *u_ciclo = u;
+                *v_ciclo = v;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Cópia de adj com os pesos w + h[u] - h[v]; arredondamentos que deixariam um peso negativo viram 0
+GrafoCSR *repesar(const GrafoCSR *adj, const float *h) {
+    GrafoCSR *g = copiar_grafo_csr(adj);
+
+    if (!g)
+        return NULL;
+
+    for (int u = 0; u < g->qtd_vertices; u++) {
+        for (int e = g->inicio[u]; e < g->inicio[u + 1]; e++) {
+            float peso = g->pesos[e] + h[u] - h[g->vizinhos[e]];
+
+            g->pesos[e] = peso > 0 ? peso : 0;
+        }
+    }
+    return g;
+}
+
+/*
+ * Dijkstra de s sobre os pesos repesados, já com as distâncias de volta aos pesos originais:
+ * dist[v] = FLT_MAX e pai[v] = -1 para os vértices não alcançáveis. Q e S são o espaço de
+ * trabalho da thread, reaproveitado de uma fonte para a outra.
+ */
+void dijkstra_repesado(const GrafoCSR *g, const float *h, int s, FilaPrioridade *Q, bool *S,
+                       float *dist, int *pai) {
+    int n = g->qtd_vertices;
+
+    for (int v = 0; v < n; v++) {
+        dist[v] = FLT_MAX;
+        pai[v] = -1;
+    }
+    memset(S, 0, n * sizeof(bool));
+    esvaziar_fila(Q);   // a fila radix também volta a aceitar chaves a partir de 0
+
+    dist[s] = 0;
+    diminuir_chave(Q, s, 0);
+
+    int u;
+    float d_u;
+    while ((u = extrair_minimo(Q, &d_u)) != -1) {
+        if (S[u])
+            continue;  // cópia obsoleta (filas radix e preguiçosa)
+        S[u] = true;
+
+        for (int e = g->inicio[u]; e < g->inicio[u + 1]; e++) {
+            int v = g->vizinhos[e];
+            float d = d_u + g->pesos[e];
+
+            if (!S[v] && d < dist[v]) {
+                dist[v] = d;
+                pai[v] = u;
+                diminuir_chave(Q, v, d);
+            }
+        }
+    }
+
+    for (int v = 0; v < n; v++)
+        if (S[v])
+            dist[v] += h[v] - h[s];
+}
+
+void exibir_linha(int s, int qtd_vertices, const float *dist, const int *pai) {
+    printf("\nFonte %d:\n", s);
+    printf("vértice            | distância (d)             | pai (pi)\n");
+    printf("-------------------|---------------------------|-------------------\n");
+
+    for (int v = 0; v < qtd_vertices; v++) {
+        printf("%-18d | ", v);
+        if (dist[v] == FLT_MAX)
+            printf("%-25s | ", "INF");
+        else
+            printf("%-25f | ", dist[v]);
+        printf("%d\n", pai[v]);
+    }
+}
+
+void exibir_uso(const char *programa) {
+    fprintf(stderr, "Uso: %s [-f fila] [-T threads] [-q] < grafo\n", programa);
+    fprintf(stderr, "  -f fila     binaria (padrão), 4aria, radix ou preguicosa\n");
+    fprintf(stderr, "  -T threads  quantidade de threads dos Dijkstras\n");
+    fprintf(stderr, "  -q          não exibe as linhas de distâncias, só o tempo\n");
+}
+
+int main(int argc, char *argv[]) {
+    TipoFila tipo_fila = FILA_BINARIA;
+    int qtd_threads = 1, opcao;
+
+    while ((opcao = getopt(argc, argv, "f:T:q")) != -1) {
+        switch (opcao) {
+            case 'f':
+                if (!fila_por_nome(optarg, &tipo_fila)) {
+                    exibir_uso(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'T':
+#ifdef _OPENMP
+                omp_set_num_threads(atoi(optarg));
+#endif
+                break;
+            case 'q':
+                verboso = false;
+                break;
+            default:
+                exibir_uso(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Entrada em texto (.graph) ou no formato binário gerado pelo converter_grafo
+    GrafoCSR *adj = carregar_grafo(STDIN_FILENO, true);
+
+    if (!adj)
+        return EXIT_FAILURE;
+
+    int n = adj->qtd_vertices, u_ciclo, v_ciclo;
+    float *h = (float *) malloc((n > 0 ? n : 1) * sizeof(float));
+
+    if (!h) {
+        desalocar_grafo_csr(adj);
+        return EXIT_FAILURE;
+    }
+
+    double inicio = tempo_atual();
+
+    if (!calcular_potenciais(adj, h, &u_ciclo, &v_ciclo)) {
+        printf("Ops! Ciclo negativo encontrado!\n");
+        printf("(%d,%d) ainda relaxa depois de %d passadas do Bellman-Ford.\n", u_ciclo, v_ciclo, n);
+        free(h);
+        desalocar_grafo_csr(adj);
+        return EXIT_FAILURE;
+    }
+
+    double fim_potenciais = tempo_atual();
+
+    GrafoCSR *g = repesar(adj, h);
+    int qtd_arcos = adj->qtd_arcos;
+
+    desalocar_grafo_csr(adj);
+    if (!g) {
+        free(h);
+        return EXIT_FAILURE;
+    }
+
+#ifdef _OPENMP
+    qtd_threads = omp_get_max_threads();
+#endif
+
+    int tam_lote = qtd_threads * FONTES_POR_THREAD;
+    float *dist = (float *) malloc((size_t) tam_lote * (n > 0 ? n : 1) * sizeof(float));
+    int *pai = (int *) malloc((size_t) tam_lote * (n > 0 ? n : 1) * sizeof(int));
+    long long pares_alcancaveis = 0;
+    bool ok = dist && pai;
+
+    // Uma região paralela só: a fila e S de cada thread (O(V) para iniciar) servem a todos os lotes
+    #pragma omp parallel
+    {
+        FilaPrioridade *Q = criar_fila_prioridade(tipo_fila, n);
+        bool *S = (bool *) malloc(n * sizeof(bool));
+
+        if (!Q || !S) {
+            #pragma omp atomic write
+            ok = false;
+        }
+        #pragma omp barrier  // ok não muda mais: todas as threads fazem os mesmos lotes
+
+        for (int primeira = 0; ok && primeira < n; primeira += tam_lote) {
+            int qtd = n - primeira < tam_lote ? n - primeira : tam_lote;
+
+            // Os Dijkstras variam muito de custo (fontes com poucos alcançáveis terminam logo)
+            #pragma omp for schedule(dynamic, 1)
+            for (int i = 0; i < qtd; i++)
+                dijkstra_repesado(g, h, primeira + i, Q, S, dist + (size_t) i * n, pai + (size_t) i * n);
+
+            // O lote é exibido antes de o próximo sobrescrever dist e pai (barreira no fim do single)
+            #pragma omp single
+            for (int i = 0; i < qtd; i++) {
+                const float *linha = dist + (size_t) i * n;
+
+                if (verboso)
+                    exibir_linha(primeira + i, n, linha, pai + (size_t) i * n);
+                for (int v = 0; v < n; v++)
+                    pares_alcancaveis += linha[v] != FLT_MAX;
+            }
+        }
+
+        free(S);
+        desalocar_fila_prioridade(Q);
+    }
+
+    double fim = tempo_atual();
+
+    if (ok)
+        printf("%sJohnson com %d vértices e %d arcos (%d thread%s): %lld pares alcançáveis, %.3f s (potenciais: %.3f s)\n",
+               verboso ? "\n" : "", n, qtd_arcos, qtd_threads, qtd_threads > 1 ? "s" : "", pares_alcancaveis,
+               fim - inicio, fim_potenciais - inicio);
+    else
+        fprintf(stderr, "Memória insuficiente.\n");
+
+    free(dist);
+    free(pai);
+    free(h);
+    desalocar_grafo_csr(g);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
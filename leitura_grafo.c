@@ -0,0 +1,509 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "leitura_grafo.h"
+
+#define TAM_BLOCO_LEITURA (1 << 20)
+#define MIN_BYTES_POR_PEDACO (1 << 20)  // abaixo disso não compensa abrir outra thread
+
+typedef struct Conteudo {
+    char *dados;
+    size_t tamanho;
+    bool mapeado;   // true: dados vem de mmap; false: de malloc
+} Conteudo;
+
+typedef struct Pedaco {
+    const char *inicio, *fim;
+    int qtd;            // arestas lidas neste pedaço
+    int capacidade;    // linhas no pedaço: limite superior de arestas
+    const char *erro;  // começo da primeira linha malformada do pedaço, ou NULL
+} Pedaco;
+
+static const double potencias_de_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool eh_espaco(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool eh_digito(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static inline const char *pular_brancos(const char *p, const char *fim) {
+    while (p < fim && (eh_espaco(*p) || *p == '\n'))
+        p++;
+    return p;
+}
+
+static inline const char *pular_espacos(const char *p, const char *fim) {
+    while (p < fim && eh_espaco(*p))
+        p++;
+    return p;
+}
+
+// Retorna NULL se não houver um inteiro em p
+static const char *ler_inteiro(const char *p, const char *fim, int *valor) {
+    bool negativo = false;
+    long acumulado = 0;
+
+    if (p < fim && (*p == '-' || *p == '+'))
+        negativo = (*p++ == '-');
+
+    if (p >= fim || !eh_digito(*p))
+        return NULL;
+
+    while (p < fim && eh_digito(*p)) {
+        acumulado = acumulado * 10 + (*p++ - '0');
+        if (acumulado > 2147483648L)
+            return NULL;
+    }
+
+    *valor = (int) (negativo ? -acumulado : acumulado);
+    return p;
+}
+
+/*
+ * Lê um número real em notação decimal ou científica. Até 19 dígitos significativos e
+ * expoentes até 22 são exatos em double; fora disso a leitura é delegada ao strtod.
+ */
+static const char *ler_real(const char *p, const char *fim, float *valor) {
+    const char *comeco = p;
+    bool negativo = false;
+    unsigned long long mantissa = 0;
+    int digitos = 0, expoente = 0;
+
+    if (p < fim && (*p == '-' || *p == '+'))
+        negativo = (*p++ == '-');
+
+    for (; p < fim && eh_digito(*p); p++, digitos++)
+        mantissa = mantissa * 10 + (*p - '0');
+
+    if (p < fim && *p == '.') {
+        for (p++; p < fim && eh_digito(*p); p++, digitos++, expoente--)
+            mantissa = mantissa * 10 + (*p - '0');
+    }
+
+    if (digitos == 0)
+        return NULL;
+
+    if (p < fim && (*p == 'e' || *p == 'E')) {
+        int e;
+        const char *depois = ler_inteiro(p + 1, fim, &e);
+
+        if (depois) {
+            expoente += e;
+            p = depois;
+        }
+    }
+
+    if (digitos > 19 || expoente > 22 || expoente < -22) {
+        char copia[128];
+        size_t n = (size_t) (p - comeco) < sizeof(copia) - 1 ? (size_t) (p - comeco) : sizeof(copia) - 1;
+
+        memcpy(copia, comeco, n);
+        copia[n] = '\0';
+        *valor = (float) strtod(copia, NULL);
+        return p;
+    }
+
+    double resultado = (double) mantissa;
+    resultado = expoente < 0 ? resultado / potencias_de_10[-expoente] : resultado * potencias_de_10[expoente];
+    *valor = (float) (negativo ? -resultado : resultado);
+    return p;
+}
+
+// Interpreta as linhas "u v [peso]" do pedaço, gravando as arestas a partir de destino
+static void interpretar_pedaco(Pedaco *pd, Aresta *destino, int qtd_vertices, bool ponderado) {
+    const char *p = pd->inicio, *fim = pd->fim;
+
+    pd->qtd = 0;
+    pd->erro = NULL;
+
+    while ((p = pular_brancos(p, fim)) < fim) {
+        const char *linha = p;
+        Aresta a;
+
+        a.peso = 1;
+        p = ler_inteiro(p, fim, &a.u);
+        if (p)
+            p = ler_inteiro(pular_espacos(p, fim), fim, &a.v);
+
+        if (!p || a.u < 0 || a.v < 0 || a.u >= qtd_vertices || a.v >= qtd_vertices) {
+            pd->erro = linha;
+            return;
+        }
+
+        p = pular_espacos(p, fim);
+        if (ponderado && p < fim && *p != '\n') {
+            p = ler_real(p, fim, &a.peso);
+            if (!p) {
+                pd->erro = linha;
+                return;
+            }
+        }
+
+        // Ignora o que sobrar da linha
+        while (p < fim && *p != '\n')
+            p++;
+
+        destino[pd->qtd++] = a;
+    }
+}
+
+static int contar_linhas(const char *p, const char *fim) {
+    int linhas = 1;  // a última linha pode não terminar em '\n'
+
+    while ((p = memchr(p, '\n', fim - p)) != NULL) {
+        linhas++;
+        p++;
+    }
+    return linhas;
+}
+
+ListaArestas *interpretar_grafo_texto(const char *texto, size_t tamanho, bool ponderado) {
+    const char *p = texto, *fim = texto + tamanho;
+    int eh_dirigido, qtd_vertices;
+
+    p = ler_inteiro(pular_brancos(p, fim), fim, &eh_dirigido);
+    if (p)
+        p = ler_inteiro(pular_brancos(p, fim), fim, &qtd_vertices);
+    if (!p || qtd_vertices < 0) {
+        fprintf(stderr, "Cabeçalho do grafo inválido: esperava o tipo (0 ou 1) e a quantidade de vértices.\n");
+        return NULL;
+    }
+
+    int qtd_pedacos = 1;
+#ifdef _OPENMP
+    qtd_pedacos = omp_get_max_threads();
+#endif
+    if ((size_t) (fim - p) / MIN_BYTES_POR_PEDACO + 1 < (size_t) qtd_pedacos)
+        qtd_pedacos = (int) ((fim - p) / MIN_BYTES_POR_PEDACO) + 1;
+
+    Pedaco *pedacos = (Pedaco *) malloc(qtd_pedacos * sizeof(Pedaco));
+    if (!pedacos)
+        return NULL;
+
+    // Cada pedaço começa logo depois de uma quebra de linha, para nenhuma linha ficar dividida
+    size_t passo = (fim - p) / qtd_pedacos;
+    const char *comeco = p;
+    for (int i = 0; i < qtd_pedacos; i++) {
+        const char *corte = (i == qtd_pedacos - 1) ? fim : p + (i + 1) * passo;
+
+        if (corte < comeco)
+            corte = comeco;
+        while (corte < fim && corte[-1] != '\n')
+            corte++;
+
+        pedacos[i].inicio = comeco;
+        pedacos[i].fim = corte;
+        comeco = corte;
+    }
+
+    long total = 0;
+    #pragma omp parallel for reduction(+:total)
+    for (int i = 0; i < qtd_pedacos; i++) {
+        pedacos[i].capacidade = contar_linhas(pedacos[i].inicio, pedacos[i].fim);
+        total += pedacos[i].capacidade;
+    }
+
+    ListaArestas *l = criar_lista_arestas(qtd_vertices, eh_dirigido, ponderado);
+    Aresta *arestas = total <= 0x7fffffff ? (Aresta *) malloc(total * sizeof(Aresta)) : NULL;
+
+    if (!l || !arestas) {
+        desalocar_lista_arestas(l);
+        free(arestas);
+        free(pedacos);
+        return NULL;
+    }
+
+    // Posição de cada pedaço no arranjo final, pelo limite superior de linhas
+    long *deslocamento = (long *) malloc(qtd_pedacos * sizeof(long));
+    if (!deslocamento) {
+        desalocar_lista_arestas(l);
+        free(arestas);
+        free(pedacos);
+        return NULL;
+    }
+    deslocamento[0] = 0;
+    for (int i = 1; i < qtd_pedacos; i++)
+        deslocamento[i] = deslocamento[i - 1] + pedacos[i - 1].capacidade;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int i = 0; i < qtd_pedacos; i++)
+        interpretar_pedaco(&pedacos[i], arestas + deslocamento[i], qtd_vertices, ponderado);
+
+    // O primeiro erro na ordem do arquivo recusa o grafo inteiro, com o número da linha
+    for (int i = 0; i < qtd_pedacos; i++) {
+        if (pedacos[i].erro) {
+            int linha = contar_linhas(texto, pedacos[i].erro);  // erro aponta para o começo da linha
+
+            fprintf(stderr, "Linha %d do grafo malformada ou com vértice fora do intervalo [0, %d).\n", linha, qtd_vertices);
+            desalocar_lista_arestas(l);
+            free(arestas);
+            free(deslocamento);
+            free(pedacos);
+            return NULL;
+        }
+    }
+
+    // Junta os pedaços na ordem do arquivo
+    int qtd = 0;
+    for (int i = 0; i < qtd_pedacos; i++) {
+        memmove(arestas + qtd, arestas + deslocamento[i], pedacos[i].qtd * sizeof(Aresta));
+        qtd += pedacos[i].qtd;
+    }
+
+    free(l->arestas);
+    l->arestas = arestas;
+    l->qtd = qtd;
+    l->capacidade = (int) total;
+
+    free(deslocamento);
+    free(pedacos);
+    return l;
+}
+
+// Conteúdo inteiro da entrada, mapeado (arquivo regular) ou copiado para a memória
+static bool obter_conteudo(int fd, Conteudo *c) {
+    struct stat info;
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        // PROT_WRITE com MAP_PRIVATE: páginas alteradas são copiadas, o arquivo nunca é modificado
+        char *dados = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+        if (dados != MAP_FAILED) {
+            c->dados = dados;
+            c->tamanho = info.st_size;
+            c->mapeado = true;
+            return true;
+        }
+    }
+
+    // Entrada não mapeável (pipe, terminal): lê tudo em blocos grandes
+    size_t tamanho = 0, capacidade = TAM_BLOCO_LEITURA;
+    char *dados = (char *) malloc(capacidade);
+    ssize_t lidos;
+
+    while (dados) {
+        if (tamanho == capacidade) {
+            char *novo = (char *) realloc(dados, 2 * capacidade);
+
+            if (!novo) {
+                free(dados);
+                return false;
+            }
+            dados = novo;
+            capacidade *= 2;
+        }
+
+        lidos = read(fd, dados + tamanho, capacidade - tamanho);
+        if (lidos <= 0)
+            break;
+        tamanho += lidos;
+    }
+
+    c->dados = dados;
+    c->tamanho = tamanho;
+    c->mapeado = false;
+    return dados != NULL;
+}
+
+static void liberar_conteudo(Conteudo *c) {
+    if (c->mapeado)
+        munmap(c->dados, c->tamanho);
+    else
+        free(c->dados);
+}
+
+static size_t alinhar(size_t deslocamento) {
+    return (deslocamento + ALINHAMENTO_BINARIO - 1) & ~(size_t) (ALINHAMENTO_BINARIO - 1);
+}
+
+static size_t preencher_ate(FILE *saida, size_t escrito, size_t alvo) {
+    while (escrito < alvo && fputc(0, saida) != EOF)
+        escrito++;
+    return escrito;
+}
+
+// Programas ponderados tratam arcos de um arquivo sem pesos como de peso 1, igual à leitura do texto
+static GrafoCSR *completar_pesos(GrafoCSR *g, bool ponderado) {
+    if (ponderado && !g->pesos) {
+        g->pesos = (float *) malloc((g->qtd_arcos > 0 ? g->qtd_arcos : 1) * sizeof(float));
+
+        if (!g->pesos) {
+            desalocar_grafo_csr(g);
+            return NULL;
+        }
+        for (int i = 0; i < g->qtd_arcos; i++)
+            g->pesos[i] = 1;
+    }
+    return g;
+}
+
+// qtd elementos a partir de desloc cabem em tamanho bytes, sem estouro nas contas
+static bool arranjo_cabe(uint64_t desloc, uint64_t qtd, size_t tam_elemento, size_t tamanho) {
+    return desloc <= tamanho && qtd <= (tamanho - desloc) / tam_elemento;
+}
+
+// Confere o cabeçalho e se os arranjos cabem no arquivo
+static bool cabecalho_valido(const CabecalhoGrafoBinario *cab, size_t tamanho) {
+    if (cab->versao != VERSAO_GRAFO_BINARIO || cab->qtd_vertices >= INT_MAX || cab->qtd_arcos > INT_MAX)
+        return false;
+    if (cab->tipo_peso != PESO_NENHUM && cab->tipo_peso != PESO_FLOAT32)
+        return false;
+
+    if (!arranjo_cabe(cab->desloc_inicio, cab->qtd_vertices + 1, sizeof(int), tamanho)
+        || !arranjo_cabe(cab->desloc_vizinhos, cab->qtd_arcos, sizeof(int), tamanho)
+        || (cab->tipo_peso == PESO_FLOAT32 && !arranjo_cabe(cab->desloc_pesos, cab->qtd_arcos, sizeof(float), tamanho)))
+        return false;
+
+    return cab->desloc_inicio % ALINHAMENTO_BINARIO == 0
+        && cab->desloc_vizinhos % ALINHAMENTO_BINARIO == 0
+        && cab->desloc_pesos % ALINHAMENTO_BINARIO == 0;
+}
+
+/*
+ * Confere o conteúdo dos arranjos, para que nenhum programa leia fora deles: inicio começa em 0,
+ * não diminui e termina em qtd_arcos, e todo vizinho está em [0, qtd_vertices). Cada linha ainda
+ * precisa ser estritamente crescente, como as que o carregador de texto monta: posicao_arco_csr
+ * faz busca binária e não acharia arcos numa linha fora de ordem ou com repetidos. Custa O(V + E),
+ * bem menos que interpretar o texto.
+ */
+static bool arranjos_validos(const GrafoCSR *g) {
+    int n = g->qtd_vertices;
+    bool ok = g->inicio[0] == 0 && g->inicio[n] == g->qtd_arcos;
+
+    #pragma omp parallel for schedule(static) reduction(&&: ok)
+    for (int u = 0; u < n; u++)
+        ok = ok && g->inicio[u] <= g->inicio[u + 1];
+
+    if (!ok)
+        return false;
+
+    #pragma omp parallel for schedule(static) reduction(&&: ok)
+    for (int e = 0; e < g->qtd_arcos; e++)
+        ok = ok && (unsigned) g->vizinhos[e] < (unsigned) n;
+
+    // Só com inicio já conferido dá para saber onde cada linha começa
+    #pragma omp parallel for schedule(static) reduction(&&: ok)
+    for (int u = 0; u < n; u++)
+        for (int e = g->inicio[u] + 1; ok && e < g->inicio[u + 1]; e++)
+            ok = g->vizinhos[e - 1] < g->vizinhos[e];
+
+    return ok;
+}
+
+/*
+ * Monta o GrafoCSR sobre o conteúdo binário. Se o conteúdo estiver mapeado, os arranjos
+ * apontam direto para o mapeamento (sem cópia) e o grafo passa a ser dono dele.
+ */
+static GrafoCSR *grafo_do_binario(Conteudo *c, bool ponderado) {
+    const CabecalhoGrafoBinario *cab = (const CabecalhoGrafoBinario *) c->dados;
+
+    if (!cabecalho_valido(cab, c->tamanho)) {
+        fprintf(stderr, "Grafo binário corrompido: cabeçalho inválido ou arquivo truncado.\n");
+        return NULL;
+    }
+
+    GrafoCSR *g = (GrafoCSR *) malloc(sizeof(GrafoCSR));
+    if (!g)
+        return NULL;
+
+    g->qtd_vertices = (int) cab->qtd_vertices;
+    g->qtd_arcos = (int) cab->qtd_arcos;
+    g->eh_dirigido = (int) cab->eh_dirigido;
+    g->inicio = (int *) (c->dados + cab->desloc_inicio);
+    g->vizinhos = (int *) (c->dados + cab->desloc_vizinhos);
+    g->pesos = cab->tipo_peso == PESO_FLOAT32 ? (float *) (c->dados + cab->desloc_pesos) : NULL;
+    g->mapeamento = c->dados;
+    g->tamanho_mapeamento = c->tamanho;
+
+    if (!arranjos_validos(g)) {
+        fprintf(stderr, "Grafo binário corrompido: arranjos inicio ou vizinhos inconsistentes.\n");
+        free(g);
+        return NULL;
+    }
+
+    if (!c->mapeado) {
+        // Sem mmap não há como evitar a cópia: o grafo recebe os próprios arranjos
+        GrafoCSR *copia = copiar_grafo_csr(g);
+
+        free(g);
+        return copia ? completar_pesos(copia, ponderado) : NULL;
+    }
+
+    c->mapeado = false;  // o mapeamento agora pertence ao grafo
+    c->dados = NULL;
+    return completar_pesos(g, ponderado);
+}
+
+GrafoCSR *carregar_grafo(int fd, bool ponderado) {
+    Conteudo c;
+    GrafoCSR *g = NULL;
+
+    if (!obter_conteudo(fd, &c))
+        return NULL;
+
+    if (c.tamanho >= sizeof(CabecalhoGrafoBinario) && memcmp(c.dados, MAGICA_GRAFO_BINARIO, 8) == 0) {
+        g = grafo_do_binario(&c, ponderado);
+    } else {
+        if (c.mapeado)
+            madvise(c.dados, c.tamanho, MADV_SEQUENTIAL);
+
+        ListaArestas *l = interpretar_grafo_texto(c.dados, c.tamanho, ponderado);
+
+        if (l) {
+            g = criar_grafo_csr(l);
+            desalocar_lista_arestas(l);
+        }
+    }
+
+    if (c.dados)
+        liberar_conteudo(&c);
+    return g;
+}
+
+int gravar_grafo_binario(const GrafoCSR *g, FILE *saida) {
+    CabecalhoGrafoBinario cab;
+    size_t tam_inicio = (g->qtd_vertices + 1) * sizeof(int);
+    size_t tam_arcos = (size_t) g->qtd_arcos * sizeof(int);
+
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magica, MAGICA_GRAFO_BINARIO, 8);
+    cab.versao = VERSAO_GRAFO_BINARIO;
+    cab.eh_dirigido = g->eh_dirigido;
+    cab.tipo_peso = g->pesos ? PESO_FLOAT32 : PESO_NENHUM;
+    cab.qtd_vertices = g->qtd_vertices;
+    cab.qtd_arcos = g->qtd_arcos;
+    cab.desloc_inicio = alinhar(sizeof(cab));
+    cab.desloc_vizinhos = alinhar(cab.desloc_inicio + tam_inicio);
+    cab.desloc_pesos = g->pesos ? alinhar(cab.desloc_vizinhos + tam_arcos) : 0;
+
+    size_t escrito = fwrite(&cab, 1, sizeof(cab), saida);
+
+    // Cada arranjo começa num deslocamento alinhado, preenchido com zeros até lá
+    escrito = preencher_ate(saida, escrito, cab.desloc_inicio);
+    escrito += fwrite(g->inicio, 1, tam_inicio, saida);
+    escrito = preencher_ate(saida, escrito, cab.desloc_vizinhos);
+    escrito += fwrite(g->vizinhos, 1, tam_arcos, saida);
+
+    if (g->pesos) {
+        escrito = preencher_ate(saida, escrito, cab.desloc_pesos);
+        escrito += fwrite(g->pesos, 1, (size_t) g->qtd_arcos * sizeof(float), saida);
+    }
+
+    size_t esperado = g->pesos ? cab.desloc_pesos + (size_t) g->qtd_arcos * sizeof(float) : cab.desloc_vizinhos + tam_arcos;
+    return escrito == esperado && !ferror(saida);
+}
@@ -0,0 +1,66 @@
+#ifndef LEITURA_GRAFO_H
+#define LEITURA_GRAFO_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "grafo_csr.h"
+
+/*
+ * Leitura do formato texto dos arquivos .graph:
+ *
+ *   <1 se dirigido, 0 caso contrário>
+ *   <quantidade de vértices>
+ *   u v [peso]
+ *   ...
+ *
+ * Uma linha malformada ou com vértice fora do intervalo recusa o grafo inteiro: o número
+ * da primeira delas sai na saída de erro e o retorno é NULL. Aresta sem peso vale 1.
+ *
+ * O texto é interpretado à mão (sem fscanf) e, com OpenMP, dividido em
+ * pedaços que são lidos em paralelo e depois concatenados na ordem do arquivo.
+ */
+
+ListaArestas *interpretar_grafo_texto(const char *texto, size_t tamanho, bool ponderado);
+
+/*
+ * Formato binário (versão 1), gerado pelo converter_grafo:
+ *
+ *   [cabeçalho de 64 bytes][inicio: int32 x (V + 1)][vizinhos: int32 x E][pesos: float32 x E]
+ *
+ * Cada arranjo começa num deslocamento múltiplo de 64 bytes, na ordem de bytes da máquina
+ * que gravou o arquivo. Assim o arquivo mapeado com mmap já é o GrafoCSR, sem cópia nem
+ * reconstrução, e programas repetidos sobre o mesmo grafo começam quase instantaneamente.
+ */
+
+#define MAGICA_GRAFO_BINARIO "GRAFOCSR"
+#define VERSAO_GRAFO_BINARIO 1
+#define ALINHAMENTO_BINARIO 64
+
+enum { PESO_NENHUM = 0, PESO_FLOAT32 = 1 };
+
+typedef struct CabecalhoGrafoBinario {
+    char magica[8];
+    uint32_t versao;
+    uint32_t eh_dirigido;
+    uint32_t tipo_peso;
+    uint32_t reservado;
+    uint64_t qtd_vertices;
+    uint64_t qtd_arcos;
+    uint64_t desloc_inicio;     // deslocamentos em bytes a partir do começo do arquivo
+    uint64_t desloc_vizinhos;
+    uint64_t desloc_pesos;     // 0 quando tipo_peso == PESO_NENHUM
+} CabecalhoGrafoBinario;
+
+/*
+ * Carrega o grafo de fd, reconhecendo o formato pelo conteúdo: binário (mapeado sem cópia
+ * quando fd é um arquivo regular) ou texto. Programas ponderados recebem peso 1 nos arcos
+ * de arquivos sem pesos.
+ */
+GrafoCSR *carregar_grafo(int fd, bool ponderado);
+// Retorna 0 em caso de erro de escrita
+int gravar_grafo_binario(const GrafoCSR *g, FILE *saida);
+
+#endif
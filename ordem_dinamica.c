@@ -0,0 +1,266 @@
+#include <stdlib.h>
+
+#include "ordem_dinamica.h"
+
+OrdemDinamica *criar_ordem_dinamica(const GrafoCSR *adj, const int *componente, int qtd_componentes) {
+    int n = adj->qtd_vertices, tam = n > 0 ? n : 1;
+    OrdemDinamica *o = (OrdemDinamica *) calloc(1, sizeof(OrdemDinamica));
+
+    if (!o)
+        return NULL;
+
+    o->qtd_vertices = n;
+    o->qtd_componentes = qtd_componentes;
+    o->adj = adj;
+    o->entrada = transpor_grafo_csr(adj);
+    o->lider = (int *) malloc(tam * sizeof(int));
+    o->proximo_membro = (int *) malloc(tam * sizeof(int));
+    o->tam = (int *) malloc(tam * sizeof(int));
+    o->posicao = (int *) malloc(tam * sizeof(int));
+    o->inserido_saida = (int *) malloc(tam * sizeof(int));
+    o->inserido_entrada = (int *) malloc(tam * sizeof(int));
+    o->marca_frente = (unsigned *) calloc(tam, sizeof(unsigned));
+    o->marca_tras = (unsigned *) calloc(tam, sizeof(unsigned));
+    o->pilha = (int *) malloc(tam * sizeof(int));
+    o->frente = (int *) malloc(tam * sizeof(int));
+    o->tras = (int *) malloc(tam * sizeof(int));
+    o->chaves = (unsigned long long *) malloc(tam * sizeof(unsigned long long));
+
+    if (!o->entrada || !o->lider || !o->proximo_membro || !o->tam || !o->posicao || !o->inserido_saida ||
+        !o->inserido_entrada || !o->marca_frente || !o->marca_tras || !o->pilha || !o->frente || !o->tras ||
+        !o->chaves) {
+        desalocar_ordem_dinamica(o);
+        return NULL;
+    }
+
+    // O primeiro vértice de cada componente a representa; pilha serve de rascunho (representante por número)
+    for (int k = 0; k < qtd_componentes; k++)
+        o->pilha[k] = -1;
+
+    for (int v = 0; v < n; v++) {
+        int k = componente[v], r = o->pilha[k];
+
+        o->inserido_saida[v] = o->inserido_entrada[v] = -1;
+        if (r == -1) {
+            o->pilha[k] = r = v;
+            o->proximo_membro[v] = v;
+            o->tam[v] = 0;
+            o->posicao[v] = qtd_componentes - 1 - k;
+        } else {
+            o->proximo_membro[v] = o->proximo_membro[r];
+            o->proximo_membro[r] = v;
+        }
+        o->lider[v] = r;
+        o->tam[r]++;
+    }
+    return o;
+}
+
+void desalocar_ordem_dinamica(OrdemDinamica *o) {
+    if (o) {
+        desalocar_grafo_csr(o->entrada);
+        free(o->lider);
+        free(o->proximo_membro);
+        free(o->tam);
+        free(o->posicao);
+        free(o->inseridos);
+        free(o->inserido_saida);
+        free(o->inserido_entrada);
+        free(o->marca_frente);
+        free(o->marca_tras);
+        free(o->pilha);
+        free(o->frente);
+        free(o->tras);
+        free(o->chaves);
+        free(o);
+    }
+}
+
+int componente_de(OrdemDinamica *o, int v) {
+    while (o->lider[v] != v) {
+        o->lider[v] = o->lider[o->lider[v]];   // compressão pela metade do caminho
+        v = o->lider[v];
+    }
+    return v;
+}
+
+int componentes_em_ordem(const OrdemDinamica *o, int *reps) {
+    int n = o->qtd_vertices, k = 0;
+
+    // As posições ficam em [0, qtd_componentes inicial), com buracos deixados pelas junções
+    for (int i = 0; i < n; i++)
+        reps[i] = -1;
+    for (int v = 0; v < n; v++)
+        if (o->lider[v] == v)
+            reps[o->posicao[v]] = v;
+    for (int i = 0; i < n; i++)
+        if (reps[i] != -1)
+            reps[k++] = reps[i];
+    return k;
+}
+
+// Empilha a componente de w se ela ainda não foi vista nesta busca e está dentro do limite
+static inline void alcancar(OrdemDinamica *o, unsigned *marca, int w, int limite, bool para_frente, int *topo) {
+    int cw = componente_de(o, w);
+
+    if (marca[cw] != o->epoca && (para_frente ? o->posicao[cw] <= limite : o->posicao[cw] >= limite)) {
+        marca[cw] = o->epoca;
+        o->pilha[(*topo)++] = cw;
+    }
+}
+
+/*
+ * Busca a partir da componente c pelos arcos de saída (para_frente) ou de entrada de todos os
+ * vértices dela, só por componentes com posição até limite (para frente) ou a partir de limite
+ * (para trás). As componentes alcançadas, incluindo c, vão para regiao; retorna quantas são.
+ */
+static int buscar_regiao(OrdemDinamica *o, int c, int limite, bool para_frente, int *regiao) {
+    const GrafoCSR *arcos = para_frente ? o->adj : o->entrada;
+    unsigned *marca = para_frente ? o->marca_frente : o->marca_tras;
+    int topo = 0, qtd = 0;
+
+    marca[c] = o->epoca;
+    o->pilha[topo++] = c;
+
+    while (topo > 0) {
+        int x = o->pilha[--topo], m = x;
+
+        regiao[qtd++] = x;
+        do {
+            for (int e = arcos->inicio[m]; e < arcos->inicio[m + 1]; e++)
+                alcancar(o, marca, arcos->vizinhos[e], limite, para_frente, &topo);
+
+            if (para_frente)
+                for (int a = o->inserido_saida[m]; a != -1; a = o->inseridos[a].prox_saida)
+                    alcancar(o, marca, o->inseridos[a].v, limite, true, &topo);
+            else
+                for (int a = o->inserido_entrada[m]; a != -1; a = o->inseridos[a].prox_entrada)
+                    alcancar(o, marca, o->inseridos[a].u, limite, false, &topo);
+
+            m = o->proximo_membro[m];
+        } while (m != x);
+    }
+    return qtd;
+}
+
+static int comparar_chaves(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *) a, y = *(const unsigned long long *) b;
+
+    return (x > y) - (x < y);
+}
+
+// Ordena as componentes de regiao[0 .. qtd - 1] pela posição
+static void ordenar_por_posicao(OrdemDinamica *o, int *regiao, int qtd) {
+    for (int i = 0; i < qtd; i++)
+        o->chaves[i] = (unsigned long long) o->posicao[regiao[i]] << 32 | (unsigned) regiao[i];
+    qsort(o->chaves, qtd, sizeof(unsigned long long), comparar_chaves);
+    for (int i = 0; i < qtd; i++)
+        regiao[i] = (int) (o->chaves[i] & 0xffffffffu);
+}
+
+static bool guardar_arco(OrdemDinamica *o, int u, int v) {
+    if (o->qtd_inseridos == o->capacidade_inseridos) {
+        int capacidade = o->capacidade_inseridos ? 2 * o->capacidade_inseridos : 1024;
+        ArcoInserido *novo = (ArcoInserido *) realloc(o->inseridos, capacidade * sizeof(ArcoInserido));
+
+        if (!novo)
+            return false;
+        o->inseridos = novo;
+        o->capacidade_inseridos = capacidade;
+    }
+
+    int a = o->qtd_inseridos++;
+
+    o->inseridos[a] = (ArcoInserido) { u, v, o->inserido_saida[u], o->inserido_entrada[v] };
+    o->inserido_saida[u] = o->inserido_entrada[v] = a;
+    return true;
+}
+
+ResultadoInsercao inserir_arco_ordem(OrdemDinamica *o, int u, int v) {
+    int x = componente_de(o, u), y = componente_de(o, v);
+
+    if (x == y)
+        return ARCO_EM_ORDEM;   // arcos dentro de uma componente não restringem a ordem
+    if (o->posicao[x] < o->posicao[y])
+        return guardar_arco(o, u, v) ? ARCO_EM_ORDEM : ARCO_SEM_MEMORIA;
+
+    // Época nova: as marcas antigas deixam de valer sem percorrer os arranjos
+    if (++o->epoca == 0) {
+        for (int i = 0; i < o->qtd_vertices; i++)
+            o->marca_frente[i] = o->marca_tras[i] = 0;
+        o->epoca = 1;
+    }
+
+    int qtd_frente = buscar_regiao(o, y, o->posicao[x], true, o->frente);
+    int qtd_tras = buscar_regiao(o, x, o->posicao[y], false, o->tras);
+    bool ciclo = o->marca_frente[x] == o->epoca;
+
+    o->componentes_visitadas += qtd_frente + qtd_tras;
+    o->qtd_reordenacoes++;
+
+    /*
+     * Sem ciclo as duas buscas são disjuntas. Com ciclo, as componentes que estão nas duas (x e y
+     * entre elas) vão para pilha e viram uma só; tras e frente ficam com as demais.
+     */
+    int qtd_nova = 0, qtd_tras_so = 0, qtd_frente_so = 0;
+
+    for (int i = 0; i < qtd_tras; i++)
+        if (o->marca_frente[o->tras[i]] == o->epoca)
+            o->pilha[qtd_nova++] = o->tras[i];
+        else
+            o->tras[qtd_tras_so++] = o->tras[i];
+    for (int i = 0; i < qtd_frente; i++)
+        if (o->marca_tras[o->frente[i]] != o->epoca)
+            o->frente[qtd_frente_so++] = o->frente[i];
+
+    ordenar_por_posicao(o, o->tras, qtd_tras_so);
+    ordenar_por_posicao(o, o->frente, qtd_frente_so);
+
+    /*
+     * Posições da região, em ordem. Os só de trás ficam com as menores e os só da frente com as
+     * maiores, de modo que cada um deles só anda para trás ou só para a frente e os arcos vindos
+     * de fora da região continuam respeitados. Com ciclo, a componente nova fica logo depois dos
+     * de trás e sobram qtd_nova - 1 posições vagas.
+     */
+    int qtd_posicoes = 0;
+
+    for (int i = 0; i < qtd_tras_so; i++)
+        o->chaves[qtd_posicoes++] = o->posicao[o->tras[i]];
+    for (int i = 0; i < qtd_nova; i++)
+        o->chaves[qtd_posicoes++] = o->posicao[o->pilha[i]];
+    for (int i = 0; i < qtd_frente_so; i++)
+        o->chaves[qtd_posicoes++] = o->posicao[o->frente[i]];
+    qsort(o->chaves, qtd_posicoes, sizeof(unsigned long long), comparar_chaves);
+    o->tam_regiao = qtd_posicoes;
+
+    int p = 0;
+
+    for (int i = 0; i < qtd_tras_so; i++)
+        o->posicao[o->tras[i]] = (int) o->chaves[p++];
+
+    if (ciclo) {
+        for (int i = 0; i < qtd_nova; i++) {
+            int c = o->pilha[i];
+
+            if (c != x) {
+                int aux = o->proximo_membro[x];   // junta as listas circulares
+
+                o->proximo_membro[x] = o->proximo_membro[c];
+                o->proximo_membro[c] = aux;
+                o->lider[c] = x;
+                o->tam[x] += o->tam[c];
+            }
+        }
+        o->posicao[x] = (int) o->chaves[p++];
+        o->qtd_componentes -= qtd_nova - 1;
+        o->qtd_ciclos++;
+    }
+
+    p = qtd_posicoes - qtd_frente_so;
+    for (int i = 0; i < qtd_frente_so; i++)
+        o->posicao[o->frente[i]] = (int) o->chaves[p++];
+
+    if (ciclo)
+        return ARCO_FECHOU_CICLO;   // (u, v) ficou dentro da componente nova e não precisa ser guardado
+    return guardar_arco(o, u, v) ? ARCO_REORDENOU : ARCO_SEM_MEMORIA;
+}
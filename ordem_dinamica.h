@@ -0,0 +1,86 @@
+#ifndef ORDEM_DINAMICA_H
+#define ORDEM_DINAMICA_H
+
+#include <stdbool.h>
+
+#include "grafo_csr.h"
+
+/*
+ * Ordem topológica mantida enquanto arcos são inseridos, pelo algoritmo de Pearce e Kelly ("A
+ * dynamic topological sort algorithm for directed acyclic graphs", 2006), estendido para juntar
+ * componentes fortemente conexas quando um arco fecha um ciclo.
+ *
+ * A ordem é entre componentes: cada uma tem uma posição, e todo arco entre componentes vai de uma
+ * posição menor para uma maior. Ao inserir (u, v) com posicao(u) > posicao(v), só a região entre
+ * as duas posições pode estar errada:
+ *
+ *   - para frente, os que v alcança sem passar de posicao(u);
+ *   - para trás, os que alcançam u sem ficar antes de posicao(v).
+ *
+ * Se a busca para frente chega a u, o arco fechou um ciclo: os que estão nas duas buscas formam,
+ * com u e v, uma única componente nova. As posições da região são então redistribuídas entre os
+ * da busca para trás, a componente nova (se houver) e os da busca para frente, cada grupo na sua
+ * ordem relativa. Nada fora da região é visitado nem muda de posição.
+ *
+ * As componentes são guardadas em união-busca, com a lista circular dos vértices de cada uma.
+ * Os arcos inseridos ficam em listas por vértice, ao lado do CSR inicial e do seu transposto.
+ */
+
+typedef struct OrdemDinamica OrdemDinamica;
+typedef struct ArcoInserido ArcoInserido;
+
+typedef enum ResultadoInsercao {
+    ARCO_EM_ORDEM,      // o arco já respeitava a ordem (ou ficou dentro de uma componente)
+    ARCO_REORDENOU,    // a região afetada foi reordenada
+    ARCO_FECHOU_CICLO, // a região foi reordenada e uma componente nova foi formada
+    ARCO_SEM_MEMORIA
+} ResultadoInsercao;
+
+struct ArcoInserido {
+    int u, v;
+    int prox_saida;    // próximo arco inserido que sai de u, ou -1
+    int prox_entrada; // próximo arco inserido que chega em v, ou -1
+};
+
+struct OrdemDinamica {
+    int qtd_vertices;
+    int qtd_componentes;
+    const GrafoCSR *adj;   // arcos iniciais, de quem chamou criar_ordem_dinamica()
+    GrafoCSR *entrada;    // transposto de adj
+
+    int *lider;            // união-busca: lider[v] == v nos representantes
+    int *proximo_membro;  // lista circular dos vértices de cada componente
+    int *tam;            // vértices da componente (no representante)
+    int *posicao;       // posição da componente na ordem (no representante)
+
+    ArcoInserido *inseridos;
+    int qtd_inseridos, capacidade_inseridos;
+    int *inserido_saida, *inserido_entrada;  // primeiro arco inserido que sai de / chega em cada vértice, ou -1
+
+    // Espaço de trabalho das buscas; as marcas valem para a inserção com a mesma época
+    unsigned *marca_frente, *marca_tras, epoca;
+    int *pilha, *frente, *tras;
+    unsigned long long *chaves;
+
+    // Estatísticas acumuladas
+    long long qtd_reordenacoes, qtd_ciclos, componentes_visitadas;
+    int tam_regiao;   // componentes na região da última inserção reordenada
+};
+
+/*
+ * Parte das componentes de adj numeradas em ordem topológica inversa (como as do cfcs() do
+ * dfs_bfs_to_scc: a componente 0 não tem arcos para as outras). adj precisa continuar válido
+ * enquanto a ordem existir. Retorna NULL se faltar memória.
+ */
+OrdemDinamica *criar_ordem_dinamica(const GrafoCSR *adj, const int *componente, int qtd_componentes);
+void desalocar_ordem_dinamica(OrdemDinamica *o);
+
+ResultadoInsercao inserir_arco_ordem(OrdemDinamica *o, int u, int v);
+
+// Representante da componente de v
+int componente_de(OrdemDinamica *o, int v);
+
+// Representantes das componentes em ordem topológica, em reps (qtd_vertices posições); retorna quantas são
+int componentes_em_ordem(const OrdemDinamica *o, int *reps);
+
+#endif
@@ -0,0 +1,194 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "ordem_topologica.h"
+
+// Níveis com menos vértices que isso são processados por uma thread só, mesmo com paralelo
+#define NIVEL_PARALELO 4096
+
+#define NAO_VISITADO 0
+#define NA_PILHA 1
+#define TERMINADO 2
+
+typedef struct BufferLocal {
+    int *vertices;
+    int tam, capacidade;
+} BufferLocal;
+
+static void inserir_buffer(BufferLocal *b, int v) {
+    if (b->tam == b->capacidade) {
+        b->capacidade = b->capacidade ? 2 * b->capacidade : 1024;
+        b->vertices = (int *) realloc(b->vertices, b->capacidade * sizeof(int));
+        assert(b->vertices != NULL);
+    }
+    b->vertices[b->tam++] = v;
+}
+
+/*
+ * Procura, por uma DFS iterativa restrita aos vértices com nivel -1, um arco para um vértice que
+ * ainda está na pilha; o ciclo é o trecho da pilha a partir dele. Todo vértice que sobrou tem um
+ * predecessor que também sobrou, então esse subgrafo sempre tem um ciclo. estado e pilha têm
+ * qtd_vertices posições.
+ */
+static int encontrar_ciclo(const GrafoCSR *adj, const int *nivel, int *estado, int *pilha, int *cursor, int *ciclo) {
+    int n = adj->qtd_vertices;
+
+    for (int v = 0; v < n; v++)
+        estado[v] = NAO_VISITADO;
+
+    for (int s = 0; s < n; s++) {
+        if (nivel[s] != -1 || estado[s] != NAO_VISITADO)
+            continue;
+
+        int topo = 0;
+
+        estado[s] = NA_PILHA;
+        pilha[topo] = s;
+        cursor[topo++] = adj->inicio[s];
+
+        while (topo > 0) {
+            int u = pilha[topo - 1];
+
+            if (cursor[topo - 1] == adj->inicio[u + 1]) {
+                estado[u] = TERMINADO;
+                topo--;
+                continue;
+            }
+
+            int w = adj->vizinhos[cursor[topo - 1]++];
+
+            if (nivel[w] != -1 || estado[w] == TERMINADO)
+                continue;
+
+            if (estado[w] == NA_PILHA) {
+                int i = topo - 1;
+
+                while (pilha[i] != w)
+                    i--;
+                memcpy(ciclo, pilha + i, (topo - i) * sizeof(int));
+                return topo - i;
+            }
+
+            estado[w] = NA_PILHA;
+            pilha[topo] = w;
+            cursor[topo++] = adj->inicio[w];
+        }
+    }
+    return 0;  // não acontece: só é chamada quando sobram vértices
+}
+
+OrdemTopologica *ordenar_por_niveis(const GrafoCSR *adj, bool paralelo) {
+    int n = adj->qtd_vertices, tam = n > 0 ? n : 1;
+    OrdemTopologica *o = (OrdemTopologica *) calloc(1, sizeof(OrdemTopologica));
+    int *grau = (int *) calloc(tam, sizeof(int));
+
+    if (o) {
+        o->qtd_vertices = n;
+        o->ordem = (int *) malloc(tam * sizeof(int));
+        o->nivel = (int *) malloc(tam * sizeof(int));
+        o->inicio_nivel = (int *) malloc((n + 1) * sizeof(int));
+    }
+    if (!o || !grau || !o->ordem || !o->nivel || !o->inicio_nivel) {
+        desalocar_ordem_topologica(o);
+        free(grau);
+        return NULL;
+    }
+
+    // Graus de entrada, numa passada pelos arcos
+    if (paralelo) {
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (int u = 0; u < n; u++)
+            for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++)
+                __atomic_fetch_add(&grau[adj->vizinhos[e]], 1, __ATOMIC_RELAXED);
+    } else {
+        for (int e = 0; e < adj->qtd_arcos; e++)
+            grau[adj->vizinhos[e]]++;
+    }
+
+    int ini = 0, fim = 0, k = 0;
+
+    for (int v = 0; v < n; v++) {
+        o->nivel[v] = -1;
+        if (grau[v] == 0) {
+            o->nivel[v] = 0;
+            o->ordem[fim++] = v;
+        }
+    }
+
+    // O nível k ocupa ordem[ini .. fim - 1]; os vértices cujo grau ele zera vão para o final
+    while (ini < fim) {
+        int prox = fim;
+
+        o->inicio_nivel[k] = ini;
+
+        if (paralelo && fim - ini >= NIVEL_PARALELO) {
+            #pragma omp parallel
+            {
+                BufferLocal saida = { NULL, 0, 0 };
+
+                #pragma omp for schedule(dynamic, 256) nowait
+                for (int i = ini; i < fim; i++) {
+                    int u = o->ordem[i];
+
+                    for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++)
+                        if (__atomic_fetch_sub(&grau[adj->vizinhos[e]], 1, __ATOMIC_RELAXED) == 1)
+                            inserir_buffer(&saida, adj->vizinhos[e]);
+                }
+
+                int desloc = __atomic_fetch_add(&prox, saida.tam, __ATOMIC_RELAXED);
+                memcpy(o->ordem + desloc, saida.vertices, saida.tam * sizeof(int));
+                free(saida.vertices);
+            }
+        } else {
+            for (int i = ini; i < fim; i++) {
+                int u = o->ordem[i];
+
+                for (int e = adj->inicio[u]; e < adj->inicio[u + 1]; e++)
+                    if (--grau[adj->vizinhos[e]] == 0)
+                        o->ordem[prox++] = adj->vizinhos[e];
+            }
+        }
+
+        for (int i = fim; i < prox; i++)
+            o->nivel[o->ordem[i]] = k + 1;
+
+        ini = fim;
+        fim = prox;
+        k++;
+    }
+    o->inicio_nivel[k] = fim;
+    o->qtd_niveis = k;
+    o->qtd_ordenados = fim;
+
+    if (fim < n) {
+        // grau não é mais necessário: vira o estado da DFS que procura o ciclo
+        int *pilha = (int *) malloc(n * sizeof(int));
+        int *cursor = (int *) malloc(n * sizeof(int));
+
+        o->ciclo = (int *) malloc(n * sizeof(int));
+        if (!pilha || !cursor || !o->ciclo) {
+            free(pilha);
+            free(cursor);
+            free(grau);
+            desalocar_ordem_topologica(o);
+            return NULL;
+        }
+        o->tam_ciclo = encontrar_ciclo(adj, o->nivel, grau, pilha, cursor, o->ciclo);
+        free(pilha);
+        free(cursor);
+    }
+
+    free(grau);
+    return o;
+}
+
+void desalocar_ordem_topologica(OrdemTopologica *o) {
+    if (o) {
+        free(o->ordem);
+        free(o->inicio_nivel);
+        free(o->nivel);
+        free(o->ciclo);
+        free(o);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef ORDEM_TOPOLOGICA_H
+#define ORDEM_TOPOLOGICA_H
+
+#include <stdbool.h>
+
+#include "grafo_csr.h"
+
+/*
+ * Ordenação topológica por níveis (algoritmo de Kahn), compartilhada pelo dfs_bfs_to_scc e pelo
+ * gad_cmfu.
+ *
+ * Os graus de entrada são contados numa passada pelos arcos. O nível 0 são os vértices sem arcos
+ * de entrada; retirá-los zera o grau de alguns sucessores, que formam o nível 1, e assim por
+ * diante. Os vértices de um mesmo nível não têm arcos entre si, então podem ser processados em
+ * paralelo, tanto aqui quanto por quem usa a ordem (o caminho mínimo no GAD, por exemplo).
+ *
+ * Se sobrarem vértices com grau de entrada positivo, o grafo tem um ciclo: a ordem fica só com os
+ * vértices que chegaram a ser retirados e um ciclo entre os que sobraram é devolvido.
+ */
+
+typedef struct OrdemTopologica OrdemTopologica;
+
+struct OrdemTopologica {
+    int qtd_vertices;
+    int qtd_ordenados;     // qtd_vertices se o grafo for acíclico
+    int *ordem;           // os vértices ordenados, nível por nível
+    int qtd_niveis;
+    int *inicio_nivel;   // nível k em ordem[inicio_nivel[k]] ... ordem[inicio_nivel[k + 1] - 1]
+    int *nivel;         // nível de cada vértice, ou -1 se ele ficou preso num ciclo
+
+    // Com ciclo: ciclo[0] -> ciclo[1] -> ... -> ciclo[tam_ciclo - 1] -> ciclo[0]; senão tam_ciclo = 0
+    int *ciclo;
+    int tam_ciclo;
+};
+
+// Com paralelo, a contagem dos graus e os níveis grandes são divididos entre as threads do OpenMP
+// (a ordem dentro de um nível passa a depender delas). Retorna NULL se faltar memória
+OrdemTopologica *ordenar_por_niveis(const GrafoCSR *adj, bool paralelo);
+void desalocar_ordem_topologica(OrdemTopologica *o);
+
+#endif